@@ -0,0 +1,98 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "glyph_atlas.h"
+#include "microui.h"
+
+// Interleaved vertex: position, pre-normalized atlas UV and RGBA colour in
+// one 20-byte record, so a quad is written with four sequential stores
+typedef struct
+{
+    float x, y;
+    float u, v;
+    mu_Color color;
+} batch_vertex_t;
+
+typedef struct batch batch_t;
+typedef struct batch_cache batch_cache_t;
+typedef struct batch_workers batch_workers_t;
+
+// Quad batch over caller-owned vertex storage. Quads are emitted as four
+// vertices (top-left, top-right, bottom-left, bottom-right) and drawn with
+// the fixed index pattern from batch_fill_indices(). When the storage is
+// full, `flush` is called and must make room, either by consuming the
+// vertices and resetting `quads` or by growing `vertices` and `capacity`.
+// If it can't, it leaves the batch full and quads are dropped and counted
+// in `overflow`.
+//
+// Quads are clipped to `clip` on the CPU, with their UVs trimmed to match,
+// so clip changes don't force a flush. Renderers that clip with a scissor
+// instead leave `clip` at its unclipped default.
+//
+// UVs refer to a GA_TEXTURE_WIDTH x GA_TEXTURE_HEIGHT texture whose first
+// pages hold the baked atlas. With `glyphs` set, text beyond ASCII is drawn
+// from that glyph atlas and its texture must be the one sampled; without
+// it, such text falls back to the baked font.
+struct batch
+{
+    batch_vertex_t *vertices;
+    int quads;
+    int capacity; // In quads
+    void (*flush)(batch_t *batch);
+    mu_Rect clip;
+    glyph_atlas_t *glyphs;
+    unsigned pages; // Glyph atlas pages drawn from since batch_init()
+    int overflow;   // Quads dropped since batch_init() as `flush` made no room
+};
+
+void batch_init(batch_t *batch, batch_vertex_t *vertices, int capacity, void (*flush)(batch_t *));
+void batch_set_clip(batch_t *batch, mu_Rect rect);
+
+// Writes the two-triangle index pattern for `quads` quads (6 indices each);
+// it never changes, so renderers build it once at init
+void batch_fill_indices(unsigned *indices, int quads);
+
+void batch_draw_rect(batch_t *batch, mu_Rect rect, mu_Color color);
+// `len` bounds the text like in mu_draw_text; -1 draws up to the terminator
+void batch_draw_text(batch_t *batch, const char *text, int len, mu_Vec2 pos, mu_Color color);
+void batch_draw_icon(batch_t *batch, int id, mu_Rect rect, mu_Color color);
+// One quad per run of adjacent columns with the same span, as in
+// mu_ColumnsCommand
+void batch_draw_columns(batch_t *batch, mu_Rect rect, const unsigned short *spans, mu_Color color);
+// The fill and four border quads of a mu_FrameCommand
+void batch_draw_frame(
+    batch_t *batch,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+);
+int batch_text_width(const char *text, int len);
+int batch_text_height(void);
+
+// Retained vertices per root container. Each container's command range is
+// hashed together with the clip rect it starts under; when both match the
+// previous frame, its vertices are copied instead of regenerated.
+batch_cache_t *batch_cache_create(void);
+void batch_cache_destroy(batch_cache_t *cache);
+
+// Draws the finished frame in `ctx` in z-order, like walking it with
+// mu_next_command(). Returns the number of root containers whose vertices
+// had to be regenerated.
+int batch_render(batch_t *batch, batch_cache_t *cache, mu_Context *ctx);
+
+// Parallel vertex generation on `threads` threads (the caller plus
+// threads - 1 workers). The command stream is cut into jobs at clip
+// commands, and long runs are cut further at command boundaries. Each job
+// writes into its own slice of a scratch buffer, and the slices are
+// appended to the batch in order, so the output is identical to the
+// sequential path. Frames estimated below `min_quads` are drawn
+// sequentially.
+batch_workers_t *batch_workers_create(int threads, int min_quads);
+void batch_workers_destroy(batch_workers_t *workers);
+
+// Draws the finished frame in `ctx`; returns the number of jobs run in
+// parallel, or 0 when the frame was drawn sequentially
+int batch_render_parallel(batch_t *batch, batch_workers_t *workers, mu_Context *ctx);
+
+#endif // BATCH_H
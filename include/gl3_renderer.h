@@ -0,0 +1,42 @@
+#ifndef GL3_RENDERER_H
+#define GL3_RENDERER_H
+
+#include "microui.h"
+
+typedef struct gl3_renderer gl3_renderer_t;
+
+// Loader for GL entry points beyond 1.1, e.g. SDL_GL_GetProcAddress
+typedef void *(*gl3_loader_t)(const char *name);
+
+// OpenGL 3.3 core-profile renderer. Every quad is one 16-byte instance
+// record (rect, colour, atlas rect) streamed through an orphaned VBO ring
+// and drawn with one instanced call per batch. Quads are clipped on the
+// CPU, so clip changes don't split batches. Works on Mesa's llvmpipe
+// (LIBGL_ALWAYS_SOFTWARE=1) when no GPU is available.
+//
+// gl3_create() needs a current 3.3 core context and returns NULL when the
+// context lacks an entry point or the shaders fail to build.
+gl3_renderer_t *gl3_create(int width, int height, gl3_loader_t loader);
+void gl3_destroy(gl3_renderer_t *r);
+
+void gl3_draw_rect(gl3_renderer_t *r, mu_Rect rect, mu_Color color);
+void gl3_draw_text(gl3_renderer_t *r, const char *text, int len, mu_Vec2 pos, mu_Color color);
+void gl3_draw_icon(gl3_renderer_t *r, int id, mu_Rect rect, mu_Color color);
+void gl3_draw_frame(
+    gl3_renderer_t *r,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+);
+void gl3_draw_columns(gl3_renderer_t *r, mu_Rect rect, const unsigned short *spans, mu_Color color);
+void gl3_set_clip_rect(gl3_renderer_t *r, mu_Rect rect);
+void gl3_clear(gl3_renderer_t *r, mu_Color color);
+
+// Draws every command of the finished frame in `ctx`
+void gl3_render(gl3_renderer_t *r, mu_Context *ctx);
+
+// Submits pending quads; call before swapping buffers
+void gl3_flush(gl3_renderer_t *r);
+
+#endif // GL3_RENDERER_H
@@ -0,0 +1,92 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include "microui.h"
+
+// Atlas texture with room for glyphs beyond ASCII. The baked atlas (icons
+// and the ASCII font) is pinned in the first pages; other glyphs are
+// shelf-packed into the remaining pages on first use, and when those are
+// full, the least recently used page is evicted.
+enum
+{
+    GA_PAGE_WIDTH = 128,
+    GA_PAGE_HEIGHT = 64,
+    GA_MAX_PAGES = 8,
+    GA_TEXTURE_WIDTH = GA_PAGE_WIDTH,
+    GA_TEXTURE_HEIGHT = GA_PAGE_HEIGHT * GA_MAX_PAGES
+};
+
+typedef struct glyph_atlas glyph_atlas_t;
+
+// Decodes the UTF-8 sequence at `s`, reading at most `len` bytes, and
+// returns its length. Malformed or truncated sequences decode as U+FFFD
+// one byte at a time.
+int ga_decode_utf8(const char *s, int len, unsigned *codepoint);
+
+// Steps `*text` over one code point, reading at most `len` bytes, and
+// returns its glyph in the baked font: the base letter of an accented one,
+// the box glyph (127) for code points without a glyph.
+int ga_next_baked(const char **text, int len);
+
+// Text metrics; a code point advances as far as its baked fallback, so
+// they don't depend on which glyphs are cached
+int ga_advance(unsigned codepoint);
+int ga_text_width(const char *text, int len);
+
+// Kernels for ASCII runs. The SIMD ones classify 16 or 32 bytes at a time,
+// gather advances from the width table with byte shuffles and lay out
+// positions with prefix sums; mixed input falls back to the scalar loop.
+typedef enum
+{
+    GA_ISA_AUTO, // Best the CPU supports
+    GA_ISA_SCALAR,
+    GA_ISA_SSSE3,
+    GA_ISA_AVX2
+} ga_isa_t;
+
+// Selects the kernels for the whole process, falling back to the best
+// supported one below `isa`, and returns the one selected; meant for
+// tests and benchmarks. Without a call, the best one is picked at first use.
+ga_isa_t ga_set_isa(ga_isa_t isa);
+const char *ga_isa_name(ga_isa_t isa);
+
+// Lays out the ASCII run at the start of `text`: at most `len` bytes,
+// ending at the terminator or the first byte beyond ASCII. Each glyph's x
+// is written to `offsets` (unless NULL), `*x` is advanced past the run,
+// and the run's length in bytes is returned.
+int ga_ascii_run(const char *text, int len, int *x, int *offsets);
+
+// `pages` counts the pinned ones and is clamped to GA_MAX_PAGES; the
+// texture is always GA_TEXTURE_WIDTH x GA_TEXTURE_HEIGHT, single channel
+glyph_atlas_t *ga_create(int pages);
+void ga_destroy(glyph_atlas_t *ga);
+const unsigned char *ga_texture(const glyph_atlas_t *ga);
+
+// Pages used since the last call are never evicted, so glyphs looked up
+// for one frame stay valid until it is drawn
+void ga_begin_frame(glyph_atlas_t *ga);
+
+// Finds or packs the glyph of `codepoint` and returns the page holding it,
+// with its texel rect in `src`. When no page can take it, the baked
+// fallback is returned instead. Safe to call from several threads.
+int ga_lookup(glyph_atlas_t *ga, unsigned codepoint, mu_Rect *src);
+
+// Steps `*text` over one code point like ga_next_baked() and returns the
+// page of its glyph, with its texel rect in `src`; accented letters are
+// drawn from `ga`, or fall back to the baked font when it is NULL. Every
+// renderer draws text through this, so they all show the same glyphs.
+int ga_next_glyph(glyph_atlas_t *ga, const char **text, int len, mu_Rect *src);
+
+// Marks pages (a bitmask of ga_lookup() results) as used this frame, for
+// vertices that are replayed without looking their glyphs up again
+void ga_touch_pages(glyph_atlas_t *ga, unsigned pages);
+
+// Bumped whenever a page is evicted; vertices generated before a change
+// may sample glyphs that are gone
+unsigned ga_epoch(const glyph_atlas_t *ga);
+
+// Takes the region written since the last call, to upload as a sub-image;
+// returns 0 when nothing changed
+int ga_take_dirty(glyph_atlas_t *ga, mu_Rect *rect);
+
+#endif // GLYPH_ATLAS_H
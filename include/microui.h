@@ -11,6 +11,10 @@
 #define MU_VERSION "2.02"
 
 #define MU_COMMANDLIST_SIZE (256 * 1024)
+// Per frame, twice over; 0 leaves scroll panels and cached regions unretained
+#ifndef MU_RETAINEDLIST_SIZE
+#define MU_RETAINEDLIST_SIZE (128 * 1024)
+#endif
 #define MU_ROOTLIST_SIZE 32
 #define MU_CONTAINERSTACK_SIZE 32
 #define MU_CLIPSTACK_SIZE 32
@@ -18,6 +22,7 @@
 #define MU_LAYOUTSTACK_SIZE 16
 #define MU_CONTAINERPOOL_SIZE 48
 #define MU_TREENODEPOOL_SIZE 48
+#define MU_CACHEPOOL_SIZE 32
 #define MU_MAX_WIDTHS 16
 #define MU_REAL float
 #define MU_REAL_FMT "%.3g"
@@ -47,6 +52,8 @@ enum
     MU_COMMAND_RECT,
     MU_COMMAND_TEXT,
     MU_COMMAND_ICON,
+    MU_COMMAND_COLUMNS,
+    MU_COMMAND_FRAME,
     MU_COMMAND_MAX
 };
 
@@ -99,7 +106,8 @@ enum
     MU_OPT_AUTOSIZE = (1 << 9),
     MU_OPT_POPUP = (1 << 10),
     MU_OPT_CLOSED = (1 << 11),
-    MU_OPT_EXPANDED = (1 << 12)
+    MU_OPT_EXPANDED = (1 << 12),
+    MU_OPT_NOCOPY = (1 << 13)
 };
 
 enum
@@ -167,7 +175,9 @@ typedef struct
     mu_Font font;
     mu_Vec2 pos;
     mu_Color color;
-    char str[1];
+    const char *ref; // The caller's string, drawn with MU_OPT_NOCOPY
+    int len;
+    char str[1]; // Null-terminated copy, unless `ref` is set
 } mu_TextCommand;
 typedef struct
 {
@@ -176,6 +186,25 @@ typedef struct
     int id;
     mu_Color color;
 } mu_IconCommand;
+// One vertical span per pixel column of `rect`, left to right: rows `top` up
+// to `bottom` (exclusive), counted from rect.y; empty where they are equal
+typedef struct
+{
+    mu_BaseCommand base;
+    mu_Rect rect;
+    mu_Color color;
+    unsigned short spans[2]; // `top` and `bottom` of each of rect.w columns
+} mu_ColumnsCommand;
+// A rect filled with `color` inside a border `border_width` wide; only
+// emitted when the context's `frame_commands` is set
+typedef struct
+{
+    mu_BaseCommand base;
+    mu_Rect rect; // Outer edge of the border
+    mu_Color color;
+    mu_Color border;
+    int border_width;
+} mu_FrameCommand;
 
 typedef union
 {
@@ -186,6 +215,8 @@ typedef union
     mu_RectCommand rect;
     mu_TextCommand text;
     mu_IconCommand icon;
+    mu_ColumnsCommand columns;
+    mu_FrameCommand frame;
 } mu_Command;
 
 typedef struct
@@ -203,6 +234,22 @@ typedef struct
     int indent;
 } mu_Layout;
 
+// Content of a scroll panel kept from the frame it was last drawn in: its
+// commands as recorded, unculled, at `scroll`
+typedef struct
+{
+    int offset, size; // Range in the retained list of `frame`
+    int frame;
+    unsigned version;
+    mu_Rect body;
+    mu_Vec2 scroll;
+    mu_Vec2 content_size;
+    int rects;    // Offset of the interactive controls' rects in the same list
+    int controls; // Their count, or -1 if there was no room for them
+    int hot;      // One of them was hovered or focused
+    mu_Id focus;  // The focused control as recording began
+} mu_Retained;
+
 typedef struct
 {
     mu_Command *head, *tail;
@@ -212,8 +259,88 @@ typedef struct
     mu_Vec2 scroll;
     int zindex;
     int open;
+    mu_Retained retained;
 } mu_Container;
 
+// A cached region, with the layout it was built from and the one it left
+typedef struct
+{
+    mu_Retained retained; // `body` is the clip rect it was drawn in
+    mu_Rect bounds;       // Union of the rects laid out in it
+    mu_Layout layout[2];
+} mu_CachedRegion;
+
+#ifdef MU_FRAME_STATS
+typedef struct
+{
+    int commands;
+    int command_bytes;
+    int clip_pushes;
+    int clip_commands;
+    int text_width_calls;
+    int pool_lookups;
+    int pool_evictions;
+} mu_StatCounters;
+
+typedef struct
+{
+    mu_Container *container;
+    int parent; /* index of the enclosing root container, or -1 */
+    mu_StatCounters counters;
+} mu_RootStats;
+
+typedef struct
+{
+    int frame;
+    int root_containers;
+    mu_StatCounters total;
+    mu_RootStats roots[MU_ROOTLIST_SIZE];
+} mu_FrameStats;
+#endif
+
+// A table whose rows are drawn on demand by `row`: only rows in view are laid
+// out, while the content size covers all of them. Rows are either all
+// `row_height` high or, with `row_height` 0, as high as `row` lays them out;
+// such rows' heights are cached in `heights` as they are drawn, and rows not
+// drawn yet are assumed to be of the default height.
+typedef struct
+{
+    int columns;
+    const int *widths;   // As for mu_layout_row()
+    const char **titles; // Titles of a header row, or NULL
+    int rows;
+    int row_height;
+    int *heights;      // Room for `rows` ints if `row_height` is 0
+    int measured_rows; // `rows` when `heights` was last cleared
+    void (*row)(mu_Context *ctx, int row, void *udata);
+    void *udata;
+} mu_Table;
+
+// A series of samples appended over time, plotted through a pyramid of the
+// min/max of blocks of 8, 16, 32... samples, so each column of the plot takes
+// O(log n) lookups however many samples it covers. `capacity` is a power of
+// two, at least 8, and `pyramid` has room for capacity / 2 floats; once the
+// samples fill up, the older half of them is dropped.
+typedef struct
+{
+    float *samples;
+    float *pyramid;
+    int capacity;
+    int count;
+} mu_Plot;
+
+// A label interned once and passed to the `_l` widget variants every frame:
+// its length and id hash are computed up front, its width the first time
+// it is drawn and again whenever the style's font changes
+typedef struct
+{
+    const char *str;
+    int len;
+    mu_Id hash;
+    mu_Font font; // Font `width` was measured with
+    int width;    // -1 until measured
+} mu_Label;
+
 typedef struct
 {
     mu_Font font;
@@ -233,6 +360,10 @@ struct mu_Context
     int (*text_width)(mu_Font font, const char *str, int len);
     int (*text_height)(mu_Font font);
     void (*draw_frame)(mu_Context *ctx, mu_Rect rect, int colorid);
+    /* options */
+    int frame_commands;    /* the renderer draws MU_COMMAND_FRAME */
+    int optimize_commands; /* mu_end() drops redundant commands */
+    int cull_occluded;     /* mu_end() drops commands hidden by root containers above */
     /* core state */
     mu_Style _style;
     mu_Style *style;
@@ -246,8 +377,20 @@ struct mu_Context
     mu_Container *hover_root;
     mu_Container *next_hover_root;
     mu_Container *scroll_target;
+    mu_Container *retaining; /* scroll panel whose content is being recorded */
+    mu_Rect retain_clip;
+    int retain_start;
+    mu_CachedRegion *caching; /* region being recorded, begun at `caching_depth` */
+    int caching_depth;
+    int cached_depth;
+    int dropped_commands; /* by the last mu_end(), with `optimize_commands` or `cull_occluded` */
+    int culled_roots;     /* root containers the last mu_end() found entirely hidden */
     char number_edit_buf[MU_MAX_FMT];
     mu_Id number_edit;
+#ifdef MU_FRAME_STATS
+    mu_FrameStats frame_stats;
+    int stats_root;
+#endif
     /* stacks */
     mu_stack(char, MU_COMMANDLIST_SIZE) command_list;
     mu_stack(mu_Container *, MU_ROOTLIST_SIZE) root_list;
@@ -255,10 +398,14 @@ struct mu_Context
     mu_stack(mu_Rect, MU_CLIPSTACK_SIZE) clip_stack;
     mu_stack(mu_Id, MU_IDSTACK_SIZE) id_stack;
     mu_stack(mu_Layout, MU_LAYOUTSTACK_SIZE) layout_stack;
+    /* by frame parity; a byte each when disabled, as arrays can't be empty */
+    mu_stack(char, MU_RETAINEDLIST_SIZE ? MU_RETAINEDLIST_SIZE : 1) retained_list[2];
     /* retained state pools */
     mu_PoolItem container_pool[MU_CONTAINERPOOL_SIZE];
     mu_Container containers[MU_CONTAINERPOOL_SIZE];
     mu_PoolItem treenode_pool[MU_TREENODEPOOL_SIZE];
+    mu_PoolItem cached_pool[MU_CACHEPOOL_SIZE];
+    mu_CachedRegion cached[MU_CACHEPOOL_SIZE];
     /* input state */
     mu_Vec2 mouse_pos;
     mu_Vec2 last_mouse_pos;
@@ -274,12 +421,64 @@ struct mu_Context
 mu_Vec2 mu_vec2(int x, int y);
 mu_Rect mu_rect(int x, int y, int w, int h);
 mu_Color mu_color(int r, int g, int b, int a);
+mu_Label mu_intern_label(const char *str); // `str` must outlive the label
 
 void mu_init(mu_Context *ctx);
 void mu_begin(mu_Context *ctx);
+// With the context's `optimize_commands` set, mu_end() also drops commands
+// that don't change the frame: clip rects set before another one or to the
+// one in effect, transparent rects, rects covered by a later opaque rect or
+// frame of the same root container, and rects merged into the one drawn
+// right before them. Dropped commands become jumps to the next command, so
+// the list keeps its layout; they are counted in `dropped_commands`.
+//
+// With `cull_occluded` set, it first drops commands hidden under root
+// containers in front of them, which cover the rect of the opaque rect or
+// frame they draw first. Rects partly hidden are cut down to their visible
+// side, and root containers hidden entirely are left out of the command
+// list's chain and counted in `culled_roots`.
 void mu_end(mu_Context *ctx);
 void mu_set_focus(mu_Context *ctx, mu_Id id);
 mu_Id mu_get_id(mu_Context *ctx, const void *data, int size);
+mu_Id mu_get_label_id(mu_Context *ctx, const mu_Label *label); // Same as for its string
+mu_Id mu_get_hash_id(mu_Context *ctx, mu_Id hash); // Mixes `hash` into the enclosing id
+
+// Ids hash their data 8 bytes per step, read as little-endian words on every
+// platform, and mix that hash into the enclosing id at runtime.
+// MU_HASH_LITERAL folds the hash of a string literal of up to 32 bytes into a
+// constant; longer literals are hashed at runtime.
+mu_Id mu_hash(const void *data, int size);
+
+#define MU_HASH_SEED 0x9ae16a3b2f90404fULL
+#define MU_HASH_PRIME 0x9e3779b97f4a7c15ULL
+#define mu_hash_fold_(x) ((x) ^ ((x) >> 32))
+#define mu_hash_step_(h, word) mu_hash_fold_(((h) ^ (word)) * MU_HASH_PRIME)
+#define mu_hash_byte_(s, i)                                                                        \
+    ((unsigned long long) ((i) < sizeof(s) - 1 ? (unsigned char) (s)[(i) < sizeof(s) ? (i) : 0]    \
+                                               : 0)                                                \
+     << (i) % 8 * 8)
+#define mu_hash_word_(s, k)                                                                        \
+    (mu_hash_byte_(s, (k) * 8) | mu_hash_byte_(s, (k) * 8 + 1) | mu_hash_byte_(s, (k) * 8 + 2) |  \
+     mu_hash_byte_(s, (k) * 8 + 3) | mu_hash_byte_(s, (k) * 8 + 4) |                             \
+     mu_hash_byte_(s, (k) * 8 + 5) | mu_hash_byte_(s, (k) * 8 + 6) |                             \
+     mu_hash_byte_(s, (k) * 8 + 7))
+#define mu_hash_words1_(s, h) mu_hash_step_(h, mu_hash_word_(s, 0))
+#define mu_hash_words2_(s, h) mu_hash_step_(mu_hash_words1_(s, h), mu_hash_word_(s, 1))
+#define mu_hash_words3_(s, h) mu_hash_step_(mu_hash_words2_(s, h), mu_hash_word_(s, 2))
+#define mu_hash_words4_(s, h) mu_hash_step_(mu_hash_words3_(s, h), mu_hash_word_(s, 3))
+#define mu_hash_literal_(s, h)                                                                     \
+    (sizeof(s) <= 1   ? (h)                                                                        \
+     : sizeof(s) <= 9  ? mu_hash_words1_(s, h)                                                     \
+     : sizeof(s) <= 17 ? mu_hash_words2_(s, h)                                                     \
+     : sizeof(s) <= 25 ? mu_hash_words3_(s, h)                                                     \
+                       : mu_hash_words4_(s, h))
+#define mu_hash_checked_(s)                                                                        \
+    ((mu_Id) (sizeof(s) > 33 ? mu_hash(s, sizeof(s) - 1)                                          \
+                             : mu_hash_literal_(s, MU_HASH_SEED ^ (sizeof(s) - 1))))
+#define MU_HASH_LITERAL(s) mu_hash_checked_("" s) // Only compiles for literals
+#define mu_get_literal_id(ctx, s) mu_get_hash_id(ctx, MU_HASH_LITERAL(s))
+// Initializer of an interned label for a literal, hashed at compile time
+#define MU_LABEL(s) {"" s, sizeof("" s) - 1, MU_HASH_LITERAL(s), NULL, -1}
 void mu_push_id(mu_Context *ctx, const void *data, int size);
 void mu_pop_id(mu_Context *ctx);
 void mu_push_clip_rect(mu_Context *ctx, mu_Rect rect);
@@ -289,6 +488,9 @@ int mu_check_clip(mu_Context *ctx, mu_Rect r);
 mu_Container *mu_get_current_container(mu_Context *ctx);
 mu_Container *mu_get_container(mu_Context *ctx, const char *name);
 void mu_bring_to_front(mu_Context *ctx, mu_Container *cnt);
+#ifdef MU_FRAME_STATS
+const mu_FrameStats *mu_get_frame_stats(mu_Context *ctx);
+#endif
 
 int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id);
 int mu_pool_get(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id);
@@ -304,6 +506,8 @@ void mu_input_text(mu_Context *ctx, const char *text);
 
 mu_Command *mu_push_command(mu_Context *ctx, int type, int size);
 int mu_next_command(mu_Context *ctx, mu_Command **cmd);
+// Text of a text command, `len` bytes long; only a copy is null-terminated
+#define mu_text_str(text) ((text)->ref ? (text)->ref : (text)->str)
 void mu_set_clip(mu_Context *ctx, mu_Rect rect);
 void mu_draw_rect(mu_Context *ctx, mu_Rect rect, mu_Color color);
 void mu_draw_box(mu_Context *ctx, mu_Rect rect, mu_Color color);
@@ -315,7 +519,34 @@ void mu_draw_text(
     mu_Vec2 pos,
     mu_Color color
 );
+// With MU_OPT_NOCOPY the command references `str` instead of copying it; the
+// caller keeps those bytes unchanged until the frame's commands are consumed
+void mu_draw_text_ex(
+    mu_Context *ctx,
+    mu_Font font,
+    const char *str,
+    int len,
+    mu_Vec2 pos,
+    mu_Color color,
+    int opt
+);
 void mu_draw_icon(mu_Context *ctx, int id, mu_Rect rect, mu_Color color);
+// A filled rect with a border inside `rect`: one MU_COMMAND_FRAME if the
+// context's `frame_commands` is set and it's fully visible, or else the fill
+// and four border rects
+void mu_draw_frame(
+    mu_Context *ctx,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+);
+// The five rects a frame is drawn as: the fill, then the top, bottom, left and
+// right sides of the border; for renderers drawing MU_COMMAND_FRAME as rects
+void mu_frame_rects(mu_Rect rect, int border_width, mu_Rect *rects);
+// Finds the next run of adjacent columns with the same span, starting at
+// column `*index`, and the rect it fills; returns 0 after the last one
+int mu_next_column_run(mu_Rect rect, const unsigned short *spans, int *index, mu_Rect *run);
 
 void mu_layout_row(mu_Context *ctx, int items, const int *widths, int height);
 void mu_layout_width(mu_Context *ctx, int width);
@@ -340,10 +571,14 @@ void mu_update_control(mu_Context *ctx, mu_Id id, mu_Rect rect, int opt);
 #define mu_begin_treenode(ctx, label) mu_begin_treenode_ex(ctx, label, 0)
 #define mu_begin_window(ctx, title, rect) mu_begin_window_ex(ctx, title, rect, 0)
 #define mu_begin_panel(ctx, name) mu_begin_panel_ex(ctx, name, 0)
+#define mu_text(ctx, text) mu_text_ex(ctx, text, 0)
+#define mu_label(ctx, text) mu_label_ex(ctx, text, 0)
 
-void mu_text(mu_Context *ctx, const char *text);
-void mu_label(mu_Context *ctx, const char *text);
+void mu_text_ex(mu_Context *ctx, const char *text, int opt);
+void mu_label_ex(mu_Context *ctx, const char *text, int opt);
+void mu_label_l(mu_Context *ctx, mu_Label *label, int opt);
 int mu_button_ex(mu_Context *ctx, const char *label, int icon, int opt);
+int mu_button_l(mu_Context *ctx, mu_Label *label, int icon, int opt);
 int mu_checkbox(mu_Context *ctx, const char *label, int *state);
 int mu_textbox_raw(mu_Context *ctx, char *buf, int bufsz, mu_Id id, mu_Rect r, int opt);
 int mu_textbox_ex(mu_Context *ctx, char *buf, int bufsz, int opt);
@@ -358,9 +593,12 @@ int mu_slider_ex(
 );
 int mu_number_ex(mu_Context *ctx, mu_Real *value, mu_Real step, const char *fmt, int opt);
 int mu_header_ex(mu_Context *ctx, const char *label, int opt);
+int mu_header_l(mu_Context *ctx, mu_Label *label, int opt);
 int mu_begin_treenode_ex(mu_Context *ctx, const char *label, int opt);
+int mu_begin_treenode_l(mu_Context *ctx, mu_Label *label, int opt);
 void mu_end_treenode(mu_Context *ctx);
 int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt);
+int mu_begin_window_l(mu_Context *ctx, mu_Label *title, mu_Rect rect, int opt);
 void mu_end_window(mu_Context *ctx);
 void mu_open_popup(mu_Context *ctx, const char *name);
 int mu_begin_popup(mu_Context *ctx, const char *name);
@@ -368,4 +606,33 @@ void mu_end_popup(mu_Context *ctx);
 void mu_begin_panel_ex(mu_Context *ctx, const char *name, int opt);
 void mu_end_panel(mu_Context *ctx);
 
+// A panel whose content only changes along with `version`. While neither
+// the version nor the panel's body changes and no control in it can be
+// hovered, its previous content is replayed, moved by the scroll since it
+// was drawn, and 0 is returned: the caller skips emitting the content but
+// still calls mu_end_panel. Otherwise MU_RES_ACTIVE is returned and the
+// content is emitted (and recorded) as in a plain panel.
+int mu_begin_scroll_panel(mu_Context *ctx, const char *name, unsigned version, int opt);
+
+// A region of widgets rebuilt only when `version` changes or input reaches
+// it. While the version, the clip rect and the layout it starts from stay the
+// same, and none of its controls is hovered, focused or under the mouse, the
+// previous frame's commands for it are copied and 0 is returned: the caller
+// skips the widgets but still calls mu_end_cached. Otherwise MU_RES_ACTIVE is
+// returned and the widgets are built (and recorded).
+int mu_begin_cached(mu_Context *ctx, mu_Id id, unsigned version);
+void mu_end_cached(mu_Context *ctx);
+
+void mu_begin_table(mu_Context *ctx, const char *name, mu_Table *table, int opt);
+void mu_end_table(mu_Context *ctx);
+
+// Plots samples, spread over the width of the next layout rect, as one
+// min/max span of the samples each pixel column covers, with values from
+// `low` to `high` from bottom to top. Samples are expected to be finite.
+void mu_plot(mu_Context *ctx, const float *samples, int count, float low, float high);
+void mu_plot_init(mu_Plot *plot, float *samples, float *pyramid, int capacity);
+void mu_plot_append(mu_Plot *plot, const float *values, int count);
+// Plots the last `window` samples of `plot`, or all of them if there are fewer
+void mu_plot_series(mu_Context *ctx, const mu_Plot *plot, int window, float low, float high);
+
 #endif
@@ -3,14 +3,52 @@
 
 #include "microui.h"
 
-void r_init(void);
-void r_draw_rect(mu_Rect rect, mu_Color color);
-void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color);
-void r_draw_icon(int id, mu_Rect rect, mu_Color color);
+typedef struct renderer renderer_t;
+
+// Backend operations. Every instance carries its own state, so one process
+// can drive several surfaces, even with different backends.
+typedef struct
+{
+    const char *name;
+    int windowed; // Presents to an SDL window and needs its event loop
+    renderer_t *(*create)(int width, int height);
+    void (*destroy)(renderer_t *r);
+    void (*clear)(renderer_t *r, mu_Color color);
+    void (*render)(renderer_t *r, mu_Context *ctx); // Draws the finished frame
+    void (*present)(renderer_t *r);
+    int (*screenshot)(renderer_t *r, const char *path); // NULL if unsupported
+} renderer_backend_t;
+
+struct renderer
+{
+    const renderer_backend_t *backend;
+    int width;
+    int height;
+};
+
+// Backends by `client.mode` name:
+//   window    OpenGL 1.x client arrays (the classic renderer)
+//   gl3       OpenGL 3.3 core-profile instanced quads
+//   software  CPU rasterizer without a window; frames can be saved as PPM
+//   null      walks the commands and discards them, to measure pure UI cost
+const renderer_backend_t *r_find_backend(const char *mode);
+
+// Factory functions; r_create returns NULL for an unknown mode or when the
+// backend can't be set up
+renderer_t *r_create(const char *mode, int width, int height);
+void r_destroy(renderer_t *r);
+
+void r_clear(renderer_t *r, mu_Color color);
+void r_render(renderer_t *r, mu_Context *ctx);
+void r_present(renderer_t *r);
+int r_screenshot(renderer_t *r, const char *path); // Returns 0 on success
+
+// Options of the `window` backend; the others ignore them
+void r_set_scissor_clip(renderer_t *r, int enabled);
+void r_set_vertex_threads(renderer_t *r, int threads, int min_quads);
+
+// Every backend draws from the same atlas, so text metrics are shared
 int r_get_text_width(const char *text, int len);
 int r_get_text_height(void);
-void r_set_clip_rect(mu_Rect rect);
-void r_clear(mu_Color color);
-void r_present(void);
 
 #endif // RENDERER_H
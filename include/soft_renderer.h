@@ -0,0 +1,92 @@
+#ifndef SOFT_RENDERER_H
+#define SOFT_RENDERER_H
+
+#include "glyph_atlas.h"
+#include "microui.h"
+
+#include <stdint.h>
+
+// Instruction sets the span kernels can be built for. SR_ISA_AUTO picks the
+// widest one the running CPU supports; SR_ISA_SCALAR is the reference path
+// the vector kernels must match bit for bit.
+typedef enum
+{
+    SR_ISA_AUTO,
+    SR_ISA_SCALAR,
+    SR_ISA_SSE2,
+    SR_ISA_AVX2
+} sr_isa_t;
+
+// Side length of the square screen tiles used by the threaded path
+#define SR_TILE_SIZE 64
+
+typedef struct sr_kernels sr_kernels_t;
+typedef struct sr_tiles sr_tiles_t;
+
+// CPU rasterizer drawing the mu_Command stream into an RGBA8 framebuffer.
+// Pixels are stored as r, g, b, a bytes (the mu_Color layout), row-major
+// with `width` pixels per row. Blending matches the GL renderer's
+// GL_SRC_ALPHA / GL_ONE_MINUS_SRC_ALPHA on all four channels.
+//
+// With threads enabled, sr_render() bins each command together with its clip
+// rect into SR_TILE_SIZE tiles and rasterizes the tiles on a worker pool.
+// Tiles own disjoint pixels and keep command order, so the output is
+// identical to the single-threaded path.
+//
+// Glyphs come from the renderer's own glyph atlas, so accented letters look
+// the same as in the GL backends.
+typedef struct
+{
+    int width;
+    int height;
+    uint32_t *pixels;
+    mu_Rect clip;
+    sr_isa_t isa;
+    const sr_kernels_t *kernels;
+    int threads;       // 0 = draw commands directly on the calling thread
+    sr_tiles_t *tiles; // Bins and worker pool, set while threads > 0
+    glyph_atlas_t *glyphs;
+} soft_renderer_t;
+
+// Factory functions
+soft_renderer_t *sr_create(int width, int height);
+void sr_destroy(soft_renderer_t *sr);
+
+// Selects the span kernels; returns the instruction set actually in use,
+// which falls back to the best supported one below the requested set
+sr_isa_t sr_set_isa(soft_renderer_t *sr, sr_isa_t isa);
+const char *sr_isa_name(sr_isa_t isa);
+
+// Rasterizes tiles on `threads` threads (the caller plus threads - 1
+// workers); 0 returns to the direct path. Returns 0 on success.
+int sr_set_threads(soft_renderer_t *sr, int threads);
+
+// Same surface as renderer.h, bound to an instance
+void sr_draw_rect(soft_renderer_t *sr, mu_Rect rect, mu_Color color);
+void sr_draw_text(soft_renderer_t *sr, const char *text, int len, mu_Vec2 pos, mu_Color color);
+void sr_draw_icon(soft_renderer_t *sr, int id, mu_Rect rect, mu_Color color);
+void sr_draw_frame(
+    soft_renderer_t *sr,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+);
+void sr_draw_columns(
+    soft_renderer_t *sr,
+    mu_Rect rect,
+    const unsigned short *spans,
+    mu_Color color
+);
+int sr_get_text_width(const char *text, int len);
+int sr_get_text_height(void);
+void sr_set_clip_rect(soft_renderer_t *sr, mu_Rect rect);
+void sr_clear(soft_renderer_t *sr, mu_Color color);
+
+// Draws every command of the finished frame in `ctx`, tiled when threads > 0
+void sr_render(soft_renderer_t *sr, mu_Context *ctx);
+
+// Writes the framebuffer as a binary PPM (alpha is dropped); returns 0 on success
+int sr_write_ppm(const soft_renderer_t *sr, const char *path);
+
+#endif // SOFT_RENDERER_H
@@ -0,0 +1,40 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Environment variable naming the Chrome trace-event JSON file to write
+#define TRACE_ENV "MICROUI_TRACE"
+
+// Set while a trace session is open; checked inline so disabled spans cost a load
+extern atomic_bool trace_active;
+
+// Session control. trace_init() starts the background flusher thread and
+// returns 0 on success; trace_shutdown() drains all buffers and closes the file.
+int trace_init(const char *path);
+int trace_init_from_env(void);
+void trace_shutdown(void);
+
+// Span recording. `name` is stored by pointer and must outlive the session
+// (string literals). Events go into a lock-free per-thread buffer; when the
+// buffer is full, events are dropped rather than blocking the caller.
+void trace_begin_event(const char *name);
+void trace_end_event(const char *name);
+void trace_set_thread_name(const char *name);
+
+#define trace_begin(name)                                                                          \
+    do {                                                                                           \
+        if (atomic_load_explicit(&trace_active, memory_order_relaxed)) {                           \
+            trace_begin_event(name);                                                               \
+        }                                                                                          \
+    } while (0)
+
+#define trace_end(name)                                                                            \
+    do {                                                                                           \
+        if (atomic_load_explicit(&trace_active, memory_order_relaxed)) {                           \
+            trace_end_event(name);                                                                 \
+        }                                                                                          \
+    } while (0)
+
+#endif // TRACE_H
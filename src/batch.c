@@ -0,0 +1,690 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "batch.h"
+#include "atlas.inl"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ATLAS_COUNT (int) (sizeof(atlas) / sizeof(atlas[0]))
+
+typedef struct
+{
+    float u0, v0, u1, v1;
+} batch_uv_t;
+
+static inline batch_uv_t texel_uv(mu_Rect r) {
+    batch_uv_t uv = {
+        r.x / (float) GA_TEXTURE_WIDTH,
+        r.y / (float) GA_TEXTURE_HEIGHT,
+        (r.x + r.w) / (float) GA_TEXTURE_WIDTH,
+        (r.y + r.h) / (float) GA_TEXTURE_HEIGHT
+    };
+    return uv;
+}
+
+// The baked atlas sits at the top of the glyph atlas texture, so its rects
+// are valid texel coordinates there
+_Static_assert(
+    sizeof(atlas_texture) <= GA_TEXTURE_WIDTH * GA_TEXTURE_HEIGHT,
+    "baked atlas must fit the glyph atlas texture"
+);
+
+// Normalized texture coordinates of every atlas entry, computed once
+static batch_uv_t atlas_uv[ATLAS_COUNT];
+static pthread_once_t atlas_uv_once = PTHREAD_ONCE_INIT;
+
+static void init_atlas_uv(void) {
+    for (int i = 0; i < ATLAS_COUNT; i++) {
+        atlas_uv[i] = texel_uv(atlas[i]);
+    }
+}
+
+void batch_init(batch_t *batch, batch_vertex_t *vertices, int capacity, void (*flush)(batch_t *)) {
+    pthread_once(&atlas_uv_once, init_atlas_uv);
+    batch->vertices = vertices;
+    batch->quads = 0;
+    batch->capacity = capacity;
+    batch->flush = flush;
+    batch->clip = mu_rect(0, 0, 0x1000000, 0x1000000);
+    batch->glyphs = NULL;
+    batch->pages = 0;
+    batch->overflow = 0;
+}
+
+void batch_set_clip(batch_t *batch, mu_Rect rect) {
+    batch->clip = rect;
+}
+
+void batch_fill_indices(unsigned *indices, int quads) {
+    for (int i = 0; i < quads; i++) {
+        unsigned element = i * 4;
+        indices[i * 6 + 0] = element + 0;
+        indices[i * 6 + 1] = element + 1;
+        indices[i * 6 + 2] = element + 2;
+        indices[i * 6 + 3] = element + 2;
+        indices[i * 6 + 4] = element + 3;
+        indices[i * 6 + 5] = element + 1;
+    }
+}
+
+/* clips `dst` to `clip`, narrowing `uv` by the same fraction on each side;
+** returns 0 when nothing is left */
+static inline int clip_quad(mu_Rect clip, mu_Rect *dst, batch_uv_t *uv) {
+    int x0 = mu_max(dst->x, clip.x);
+    int y0 = mu_max(dst->y, clip.y);
+    int x1 = mu_min(dst->x + dst->w, clip.x + clip.w);
+    int y1 = mu_min(dst->y + dst->h, clip.y + clip.h);
+    if (x0 >= x1 || y0 >= y1) {
+        return 0;
+    }
+    if (x0 != dst->x || y0 != dst->y || x1 != dst->x + dst->w || y1 != dst->y + dst->h) {
+        float du = (uv->u1 - uv->u0) / dst->w;
+        float dv = (uv->v1 - uv->v0) / dst->h;
+        batch_uv_t r = {
+            uv->u0 + (x0 - dst->x) * du,
+            uv->v0 + (y0 - dst->y) * dv,
+            uv->u0 + (x1 - dst->x) * du,
+            uv->v0 + (y1 - dst->y) * dv
+        };
+        *uv = r;
+        *dst = mu_rect(x0, y0, x1 - x0, y1 - y0);
+    }
+    return 1;
+}
+
+/* writes one quad at `v`. Colour bytes may alias anything, so callers keep
+** the write position in a local rather than re-reading `batch` per quad */
+static inline void
+write_quad(batch_vertex_t *v, mu_Rect dst, const batch_uv_t *uv, mu_Color color) {
+    float x0 = dst.x, y0 = dst.y;
+    float x1 = dst.x + dst.w, y1 = dst.y + dst.h;
+    v[0] = (batch_vertex_t) {x0, y0, uv->u0, uv->v0, color};
+    v[1] = (batch_vertex_t) {x1, y0, uv->u1, uv->v0, color};
+    v[2] = (batch_vertex_t) {x0, y1, uv->u0, uv->v1, color};
+    v[3] = (batch_vertex_t) {x1, y1, uv->u1, uv->v1, color};
+}
+
+static void push_quad(batch_t *batch, mu_Rect dst, int id, mu_Color color) {
+    batch_uv_t uv = atlas_uv[id];
+    if (!clip_quad(batch->clip, &dst, &uv)) {
+        return;
+    }
+    if (batch->quads == batch->capacity) {
+        batch->flush(batch);
+        if (batch->quads == batch->capacity) {
+            batch->overflow++;
+            return;
+        }
+    }
+    write_quad(batch->vertices + batch->quads * 4, dst, &uv, color);
+    batch->quads++;
+}
+
+void batch_draw_rect(batch_t *batch, mu_Rect rect, mu_Color color) {
+    push_quad(batch, rect, ATLAS_WHITE, color);
+}
+
+void batch_draw_text(batch_t *batch, const char *text, int len, mu_Vec2 pos, mu_Color color) {
+    mu_Rect dst = {pos.x, pos.y, 0, 0};
+    mu_Rect clip = batch->clip;
+    int quads = batch->quads;
+    if (len < 0) {
+        len = INT_MAX;
+    }
+    for (const char *p = text; p - text < len && *p;) {
+        unsigned char chr = *p;
+        mu_Rect glyph = dst;
+        batch_uv_t uv;
+        if (chr < 0x80) {
+            /* ASCII indexes the baked atlas, no lookup needed */
+            int id = ATLAS_FONT + chr;
+            glyph.w = atlas[id].w;
+            glyph.h = atlas[id].h;
+            uv = atlas_uv[id];
+            p++;
+        }
+        else {
+            mu_Rect src;
+            int page = ga_next_glyph(batch->glyphs, &p, len - (p - text), &src);
+            if (batch->glyphs) {
+                batch->pages |= 1u << page;
+            }
+            glyph.w = src.w;
+            glyph.h = src.h;
+            uv = texel_uv(src);
+        }
+        dst.x += glyph.w;
+
+        if (!clip_quad(clip, &glyph, &uv)) {
+            continue;
+        }
+        if (quads == batch->capacity) {
+            batch->quads = quads;
+            batch->flush(batch);
+            quads = batch->quads;
+            if (quads == batch->capacity) {
+                batch->overflow++;
+                continue;
+            }
+        }
+        write_quad(batch->vertices + quads * 4, glyph, &uv, color);
+        quads++;
+    }
+    batch->quads = quads;
+}
+
+void batch_draw_icon(batch_t *batch, int id, mu_Rect rect, mu_Color color) {
+    mu_Rect src = atlas[id];
+    int x = rect.x + (rect.w - src.w) / 2;
+    int y = rect.y + (rect.h - src.h) / 2;
+    push_quad(batch, mu_rect(x, y, src.w, src.h), id, color);
+}
+
+void batch_draw_columns(batch_t *batch, mu_Rect rect, const unsigned short *spans, mu_Color color) {
+    mu_Rect run;
+    for (int i = 0; mu_next_column_run(rect, spans, &i, &run);) {
+        push_quad(batch, run, ATLAS_WHITE, color);
+    }
+}
+
+void batch_draw_frame(
+    batch_t *batch,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+) {
+    mu_Rect rects[5];
+    mu_frame_rects(rect, border_width, rects);
+    batch_draw_rect(batch, rects[0], color);
+    for (int i = 1; i < 5; i++) {
+        batch_draw_rect(batch, rects[i], border);
+    }
+}
+
+int batch_text_width(const char *text, int len) {
+    return ga_text_width(text, len);
+}
+
+int batch_text_height(void) {
+    return 18;
+}
+
+/*============================================================================
+** retained container vertices
+**============================================================================*/
+
+typedef struct
+{
+    uint64_t hash;
+    mu_Rect clip_in;  // Clip rect the range started under
+    mu_Rect clip_out; // Clip rect the range left behind
+    batch_vertex_t *vertices;
+    int quads;
+    int capacity;
+    unsigned pages; // Glyph atlas pages the vertices sample
+    int valid;
+} batch_range_t;
+
+// Ranges are indexed by container pool slot; a slot reused by another
+// window simply hashes differently
+struct batch_cache
+{
+    batch_range_t ranges[MU_CONTAINERPOOL_SIZE];
+    batch_t recorder;
+    unsigned epoch; // Glyph atlas epoch the ranges were recorded in
+};
+
+batch_cache_t *batch_cache_create(void) {
+    return calloc(1, sizeof(batch_cache_t));
+}
+
+void batch_cache_destroy(batch_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+    for (int i = 0; i < MU_CONTAINERPOOL_SIZE; i++) {
+        free(cache->ranges[i].vertices);
+    }
+    free(cache);
+}
+
+/* the recorder grows its range instead of dropping vertices; out of memory,
+** it overflows and the container is drawn uncached */
+static void grow_range(batch_t *batch) {
+    int capacity = batch->capacity ? batch->capacity * 2 : 256;
+    batch_vertex_t *vertices = realloc(batch->vertices, capacity * 4 * sizeof(batch_vertex_t));
+    if (!vertices) {
+        return;
+    }
+    batch->vertices = vertices;
+    batch->capacity = capacity;
+}
+
+static void draw_command(batch_t *batch, mu_Command *cmd) {
+    switch (cmd->type) {
+    case MU_COMMAND_TEXT:
+        batch_draw_text(
+            batch, mu_text_str(&cmd->text), cmd->text.len, cmd->text.pos, cmd->text.color
+        );
+        break;
+    case MU_COMMAND_RECT:
+        batch_draw_rect(batch, cmd->rect.rect, cmd->rect.color);
+        break;
+    case MU_COMMAND_ICON:
+        batch_draw_icon(batch, cmd->icon.id, cmd->icon.rect, cmd->icon.color);
+        break;
+    case MU_COMMAND_COLUMNS:
+        batch_draw_columns(batch, cmd->columns.rect, cmd->columns.spans, cmd->columns.color);
+        break;
+    case MU_COMMAND_FRAME:
+        batch_draw_frame(
+            batch,
+            cmd->frame.rect,
+            cmd->frame.color,
+            cmd->frame.border,
+            cmd->frame.border_width
+        );
+        break;
+    case MU_COMMAND_CLIP:
+        batch_set_clip(batch, cmd->clip.rect);
+        break;
+    }
+}
+
+static inline uint64_t hash_bytes(uint64_t h, const void *data, size_t size) {
+    const unsigned char *p = data;
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = ((h << 5 | h >> 59) ^ word) * 0x517cc1b727220a95;
+    }
+    while (size--) {
+        h = ((h << 5 | h >> 59) ^ *p++) * 0x517cc1b727220a95;
+    }
+    return h;
+}
+
+/* steps through one root container's commands; nested roots (popups) are
+** skipped through their head jumps, as they are drawn as roots of their own */
+static inline mu_Command *next_command(mu_Command *cmd) {
+    if (cmd->type == MU_COMMAND_JUMP) {
+        return cmd->jump.dst;
+    }
+    return (mu_Command *) ((char *) cmd + cmd->base.size);
+}
+
+/* the head jump skips the whole range, so the walk starts right behind it */
+#define each_container_command(cnt, cmd)                                                           \
+    for (mu_Command *cmd = (mu_Command *) ((char *) (cnt)->head + sizeof(mu_JumpCommand));         \
+         cmd != (cnt)->tail;                                                                       \
+         cmd = next_command(cmd))
+
+static uint64_t hash_container(mu_Container *cnt) {
+    uint64_t h = 0xcbf29ce484222325;
+    each_container_command(cnt, cmd) {
+        switch (cmd->type) {
+        case MU_COMMAND_JUMP:
+            break;
+        case MU_COMMAND_TEXT:
+            /* field by field: the padding is never written, the bytes after
+            ** the string's terminator are stale, and a referenced string may
+            ** change behind the same pointer */
+            h = hash_bytes(h, &cmd->type, sizeof(cmd->type));
+            h = hash_bytes(h, &cmd->text.font, sizeof(cmd->text.font));
+            h = hash_bytes(h, &cmd->text.pos, sizeof(cmd->text.pos));
+            h = hash_bytes(h, &cmd->text.color, sizeof(cmd->text.color));
+            h = hash_bytes(h, &cmd->text.len, sizeof(cmd->text.len));
+            h = hash_bytes(h, mu_text_str(&cmd->text), cmd->text.len);
+            break;
+        default:
+            h = hash_bytes(h, cmd, cmd->base.size);
+            break;
+        }
+    }
+    return h;
+}
+
+/* copies generated quads into the batch, flushing whenever it fills up */
+static void append_quads(batch_t *batch, const batch_vertex_t *vertices, int quads) {
+    for (int done = 0; done < quads;) {
+        if (batch->quads == batch->capacity) {
+            batch->flush(batch);
+            if (batch->quads == batch->capacity) {
+                batch->overflow += quads - done;
+                return;
+            }
+        }
+        int n = mu_min(quads - done, batch->capacity - batch->quads);
+        memcpy(
+            batch->vertices + batch->quads * 4,
+            vertices + done * 4,
+            n * 4 * sizeof(batch_vertex_t)
+        );
+        batch->quads += n;
+        done += n;
+    }
+}
+
+static int rect_equal(mu_Rect a, mu_Rect b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+int batch_render(batch_t *batch, batch_cache_t *cache, mu_Context *ctx) {
+    int regenerated = 0;
+    if (batch->glyphs && ga_epoch(batch->glyphs) != cache->epoch) {
+        /* a page was evicted; cached vertices may sample its old glyphs */
+        for (int i = 0; i < MU_CONTAINERPOOL_SIZE; i++) {
+            cache->ranges[i].valid = 0;
+        }
+        cache->epoch = ga_epoch(batch->glyphs);
+    }
+    for (int i = 0; i < ctx->root_list.idx; i++) {
+        mu_Container *cnt = ctx->root_list.items[i];
+        batch_range_t *range = &cache->ranges[cnt - ctx->containers];
+        uint64_t hash = hash_container(cnt);
+
+        if (!range->valid || range->hash != hash || !rect_equal(range->clip_in, batch->clip)) {
+            batch_t *rec = &cache->recorder;
+            batch_init(rec, range->vertices, range->capacity, grow_range);
+            rec->clip = batch->clip;
+            rec->glyphs = batch->glyphs;
+            each_container_command(cnt, cmd) {
+                draw_command(rec, cmd);
+            }
+            range->vertices = rec->vertices;
+            range->capacity = rec->capacity;
+            range->valid = !rec->overflow;
+            regenerated++;
+            if (rec->overflow) {
+                /* no memory to keep its vertices in */
+                each_container_command(cnt, cmd) {
+                    draw_command(batch, cmd);
+                }
+                continue;
+            }
+            range->hash = hash;
+            range->clip_in = batch->clip;
+            range->clip_out = rec->clip;
+            range->quads = rec->quads;
+            range->pages = rec->pages;
+        }
+        else if (batch->glyphs && range->pages) {
+            /* keep the pages of replayed vertices from being evicted */
+            ga_touch_pages(batch->glyphs, range->pages);
+        }
+        batch->pages |= range->pages;
+        append_quads(batch, range->vertices, range->quads);
+        batch->clip = range->clip_out;
+    }
+    return regenerated;
+}
+
+/*============================================================================
+** parallel vertex generation
+**============================================================================*/
+
+// Quads a job aims for when a run between clip commands is cut further
+#define BATCH_JOB_QUADS 1024
+
+typedef struct
+{
+    int first, count; // Slice of `cmds`
+    mu_Rect clip;     // Clip rect in effect when the job starts
+    int offset;       // First quad of the job's scratch slice
+    int estimate;     // Upper bound of the quads it generates
+    int quads;        // Quads actually generated
+    unsigned pages;   // Glyph atlas pages drawn from
+    int overflow;     // Quads that didn't fit the slice
+} batch_job_t;
+
+struct batch_workers
+{
+    int min_quads;
+
+    /* per-frame jobs */
+    mu_Command **cmds;
+    int cmd_count, cmd_capacity;
+    batch_job_t *jobs;
+    int job_count, job_capacity;
+    batch_vertex_t *scratch;
+    int scratch_capacity; // In quads
+    mu_Rect clip_out;     // Clip rect the frame leaves behind
+    glyph_atlas_t *glyphs;
+
+    /* worker pool; each dispatch bumps `generation` */
+    pthread_t *threads;
+    int thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned generation;
+    int pending;
+    bool quit;
+    atomic_int next_job;
+};
+
+/* upper bound of the quads a command generates; clipping only drops some */
+static int estimate_quads(mu_Command *cmd) {
+    switch (cmd->type) {
+    case MU_COMMAND_TEXT:
+        return cmd->text.len;
+    case MU_COMMAND_RECT:
+    case MU_COMMAND_ICON:
+        return 1;
+    case MU_COMMAND_COLUMNS:
+        return cmd->columns.rect.w;
+    case MU_COMMAND_FRAME:
+        return 5;
+    }
+    return 0;
+}
+
+/* returns `items` grown to hold `count` entries, or NULL when out of memory */
+static void *reserve(void *items, int *capacity, int count, size_t size) {
+    if (count <= *capacity) {
+        return items;
+    }
+    int n = mu_max(count, *capacity * 2);
+    void *p = realloc(items, n * size);
+    if (p) {
+        *capacity = n;
+    }
+    return p;
+}
+
+/* cuts the frame into jobs; returns the estimated quad count, or -1 when out
+** of memory */
+static int build_jobs(batch_workers_t *w, mu_Rect clip, mu_Context *ctx) {
+    batch_job_t *job = NULL;
+    int total = 0;
+    w->cmd_count = 0;
+    w->job_count = 0;
+
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        if (cmd->type == MU_COMMAND_CLIP) {
+            clip = cmd->clip.rect;
+            job = NULL;
+            continue;
+        }
+        int estimate = estimate_quads(cmd);
+        if (estimate == 0) {
+            continue;
+        }
+        if (!job || job->estimate >= BATCH_JOB_QUADS) {
+            batch_job_t *jobs =
+                reserve(w->jobs, &w->job_capacity, w->job_count + 1, sizeof(batch_job_t));
+            if (!jobs) {
+                return -1;
+            }
+            w->jobs = jobs;
+            job = &w->jobs[w->job_count++];
+            *job = (batch_job_t) {w->cmd_count, 0, clip, total, 0, 0, 0, 0};
+        }
+        mu_Command **cmds =
+            reserve(w->cmds, &w->cmd_capacity, w->cmd_count + 1, sizeof(mu_Command *));
+        if (!cmds) {
+            return -1;
+        }
+        w->cmds = cmds;
+        w->cmds[w->cmd_count++] = cmd;
+        job->count++;
+        job->estimate += estimate;
+        total += estimate;
+    }
+    w->clip_out = clip;
+
+    batch_vertex_t *scratch =
+        reserve(w->scratch, &w->scratch_capacity, total, 4 * sizeof(batch_vertex_t));
+    if (!scratch && total > 0) {
+        return -1;
+    }
+    w->scratch = scratch;
+    return total;
+}
+
+/* job slices are sized by the estimate, which is an upper bound; should it
+** ever fall short, the slice is left full and the frame is drawn again
+** sequentially */
+static void slice_overflow(batch_t *batch) {
+    (void) batch;
+}
+
+static void run_jobs(batch_workers_t *w) {
+    int index;
+    while ((index = atomic_fetch_add(&w->next_job, 1)) < w->job_count) {
+        batch_job_t *job = &w->jobs[index];
+        batch_t slice;
+        batch_init(&slice, w->scratch + job->offset * 4, job->estimate, slice_overflow);
+        slice.clip = job->clip;
+        slice.glyphs = w->glyphs;
+        for (int i = job->first; i < job->first + job->count; i++) {
+            draw_command(&slice, w->cmds[i]);
+        }
+        job->quads = slice.quads;
+        job->pages = slice.pages;
+        job->overflow = slice.overflow;
+    }
+}
+
+static void *worker_main(void *arg) {
+    batch_workers_t *w = arg;
+    unsigned seen = 0;
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->generation == seen && !w->quit) {
+            pthread_cond_wait(&w->wake, &w->lock);
+        }
+        if (w->quit) {
+            break;
+        }
+        seen = w->generation;
+        pthread_mutex_unlock(&w->lock);
+        run_jobs(w);
+        pthread_mutex_lock(&w->lock);
+        if (--w->pending == 0) {
+            pthread_cond_signal(&w->done);
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+void batch_workers_destroy(batch_workers_t *w) {
+    if (!w) {
+        return;
+    }
+    pthread_mutex_lock(&w->lock);
+    w->quit = true;
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+    for (int i = 0; i < w->thread_count; i++) {
+        pthread_join(w->threads[i], NULL);
+    }
+    pthread_cond_destroy(&w->done);
+    pthread_cond_destroy(&w->wake);
+    pthread_mutex_destroy(&w->lock);
+    free(w->threads);
+    free(w->cmds);
+    free(w->jobs);
+    free(w->scratch);
+    free(w);
+}
+
+batch_workers_t *batch_workers_create(int threads, int min_quads) {
+    pthread_once(&atlas_uv_once, init_atlas_uv);
+    batch_workers_t *w = calloc(1, sizeof(batch_workers_t));
+    if (!w) {
+        return NULL;
+    }
+    w->min_quads = min_quads;
+    w->threads = calloc(mu_max(threads, 1), sizeof(pthread_t));
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->wake, NULL);
+    pthread_cond_init(&w->done, NULL);
+    if (!w->threads) {
+        batch_workers_destroy(w);
+        return NULL;
+    }
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&w->threads[i], NULL, worker_main, w) != 0) {
+            batch_workers_destroy(w);
+            return NULL;
+        }
+        w->thread_count++;
+    }
+    return w;
+}
+
+static void draw_sequential(batch_t *batch, mu_Context *ctx) {
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        draw_command(batch, cmd);
+    }
+}
+
+int batch_render_parallel(batch_t *batch, batch_workers_t *w, mu_Context *ctx) {
+    int estimate = build_jobs(w, batch->clip, ctx);
+    if (estimate < 0 || estimate < w->min_quads) {
+        draw_sequential(batch, ctx);
+        return 0;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    w->glyphs = batch->glyphs;
+    atomic_store(&w->next_job, 0);
+    w->pending = w->thread_count;
+    w->generation++;
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+
+    run_jobs(w);
+
+    pthread_mutex_lock(&w->lock);
+    while (w->pending > 0) {
+        pthread_cond_wait(&w->done, &w->lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    for (int i = 0; i < w->job_count; i++) {
+        if (w->jobs[i].overflow) {
+            draw_sequential(batch, ctx);
+            return 0;
+        }
+    }
+    /* submit in command order */
+    for (int i = 0; i < w->job_count; i++) {
+        append_quads(batch, w->scratch + w->jobs[i].offset * 4, w->jobs[i].quads);
+        batch->pages |= w->jobs[i].pages;
+    }
+    batch->clip = w->clip_out;
+    return w->job_count;
+}
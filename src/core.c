@@ -2,6 +2,7 @@
 #define _GNU_SOURCE
 
 #include "core.h"
+#include "trace.h"
 #include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -235,9 +236,12 @@ static void ctx_abort(execution_context_t *ctx) {
 static void execute_sequential(execution_context_t *ctx) {
     callback_chain_t *current = ctx->chain;
 
+    trace_begin("execute_sequential");
     while (current && !ctx->completed) {
         if (current->callback) {
+            trace_begin("callback");
             current->callback(ctx->argc, ctx->argv, ctx->envp, ctx);
+            trace_end("callback");
             current->result = RESULT_SUCCESS;
 
             if (ctx->on_next) {
@@ -246,6 +250,7 @@ static void execute_sequential(execution_context_t *ctx) {
         }
         current = current->next;
     }
+    trace_end("execute_sequential");
 
     ctx->completed = true;
     if (ctx->on_complete) {
@@ -292,9 +297,11 @@ static void execute_parallel(execution_context_t *ctx) {
     }
 
     // Wait for all threads
+    trace_begin("execute_parallel");
     for (int i = 0; i < callback_count; i++) {
         pthread_join(threads[i], NULL);
     }
+    trace_end("execute_parallel");
 
     ctx->completed = true;
     if (ctx->on_complete) {
@@ -321,7 +328,10 @@ static void *thread_callback_wrapper(void *arg) {
     thread_data_t *data = (thread_data_t *) arg;
 
     if (data->callback) {
+        trace_set_thread_name("executor");
+        trace_begin("callback");
         data->callback(data->ctx->argc, data->ctx->argv, data->ctx->envp, data->ctx);
+        trace_end("callback");
 
         pthread_mutex_lock(data->mutex);
         *(data->result) = RESULT_SUCCESS;
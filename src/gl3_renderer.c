@@ -0,0 +1,431 @@
+#include "gl3_renderer.h"
+#include "atlas.inl"
+#include "glyph_atlas.h"
+#include "trace.h"
+#include <SDL2/SDL_opengl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL3_BATCH_INSTANCES 16384
+#define GL3_RING_BYTES (4 * 1024 * 1024)
+
+// One quad: destination rect, colour and glyph atlas source rect. The
+// texture is 128 texels wide, so `sx` takes 7 bits and its top bit holds
+// bit 8 of the source y; sizes are at most a glyph's.
+typedef struct
+{
+    int16_t x, y, w, h;
+    mu_Color color;
+    uint8_t sx, sy, sw, sh;
+} gl3_instance_t;
+
+_Static_assert(sizeof(gl3_instance_t) == 16, "instance record must stay 16 bytes");
+_Static_assert(GA_TEXTURE_WIDTH <= 128 && GA_TEXTURE_HEIGHT <= 512, "source must fit 7 + 9 bits");
+_Static_assert(
+    sizeof(atlas_texture) <= GA_TEXTURE_WIDTH * GA_TEXTURE_HEIGHT,
+    "baked atlas must fit the glyph atlas texture"
+);
+
+// Entry points above GL 1.1, loaded at runtime
+#define GL3_FUNCTIONS(X)                                                                           \
+    X(PFNGLACTIVETEXTUREPROC, ActiveTexture)                                                       \
+    X(PFNGLATTACHSHADERPROC, AttachShader)                                                         \
+    X(PFNGLBINDBUFFERPROC, BindBuffer)                                                             \
+    X(PFNGLBINDVERTEXARRAYPROC, BindVertexArray)                                                   \
+    X(PFNGLBUFFERDATAPROC, BufferData)                                                             \
+    X(PFNGLCOMPILESHADERPROC, CompileShader)                                                       \
+    X(PFNGLCREATEPROGRAMPROC, CreateProgram)                                                       \
+    X(PFNGLCREATESHADERPROC, CreateShader)                                                         \
+    X(PFNGLDELETEBUFFERSPROC, DeleteBuffers)                                                       \
+    X(PFNGLDELETEPROGRAMPROC, DeleteProgram)                                                       \
+    X(PFNGLDELETESHADERPROC, DeleteShader)                                                         \
+    X(PFNGLDELETEVERTEXARRAYSPROC, DeleteVertexArrays)                                             \
+    X(PFNGLDRAWARRAYSINSTANCEDPROC, DrawArraysInstanced)                                           \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray)                                   \
+    X(PFNGLGENBUFFERSPROC, GenBuffers)                                                             \
+    X(PFNGLGENVERTEXARRAYSPROC, GenVertexArrays)                                                   \
+    X(PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog)                                               \
+    X(PFNGLGETPROGRAMIVPROC, GetProgramiv)                                                         \
+    X(PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog)                                                 \
+    X(PFNGLGETSHADERIVPROC, GetShaderiv)                                                           \
+    X(PFNGLGETUNIFORMLOCATIONPROC, GetUniformLocation)                                             \
+    X(PFNGLLINKPROGRAMPROC, LinkProgram)                                                           \
+    X(PFNGLMAPBUFFERRANGEPROC, MapBufferRange)                                                     \
+    X(PFNGLSHADERSOURCEPROC, ShaderSource)                                                         \
+    X(PFNGLUNIFORM1IPROC, Uniform1i)                                                               \
+    X(PFNGLUNIFORM2FPROC, Uniform2f)                                                               \
+    X(PFNGLUNMAPBUFFERPROC, UnmapBuffer)                                                           \
+    X(PFNGLUSEPROGRAMPROC, UseProgram)                                                             \
+    X(PFNGLVERTEXATTRIBDIVISORPROC, VertexAttribDivisor)                                           \
+    X(PFNGLVERTEXATTRIBIPOINTERPROC, VertexAttribIPointer)                                         \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, VertexAttribPointer)
+
+typedef struct
+{
+#define GL3_MEMBER(type, name) type name;
+    GL3_FUNCTIONS(GL3_MEMBER)
+#undef GL3_MEMBER
+} gl3_api_t;
+
+struct gl3_renderer
+{
+    gl3_api_t gl;
+    int width;
+    int height;
+    mu_Rect clip;
+
+    GLuint program;
+    GLuint vao;
+    GLuint vbo;
+    GLuint texture;
+    GLint viewport_loc;
+    size_t ring_offset; // Next free byte in the VBO ring
+    glyph_atlas_t *glyphs;
+
+    gl3_instance_t instances[GL3_BATCH_INSTANCES];
+    int count;
+};
+
+static const char *vertex_source =
+    "#version 330 core\n"
+    "layout(location = 0) in ivec4 a_rect;\n"
+    "layout(location = 1) in vec4 a_color;\n"
+    "layout(location = 2) in uvec4 a_src;\n"
+    "uniform vec2 u_viewport;\n"
+    "uniform vec2 u_atlas_size;\n"
+    "out vec2 v_uv;\n"
+    "out vec4 v_color;\n"
+    "void main() {\n"
+    "    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "    vec2 pos = vec2(a_rect.xy) + corner * vec2(a_rect.zw);\n"
+    "    uvec2 src = uvec2(a_src.x & 127u, a_src.y | (a_src.x >> 7) << 8);\n"
+    "    v_uv = (vec2(src) + corner * vec2(a_src.zw)) / u_atlas_size;\n"
+    "    v_color = a_color;\n"
+    "    gl_Position = vec4(pos / u_viewport * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);\n"
+    "}\n";
+
+static const char *fragment_source =
+    "#version 330 core\n"
+    "in vec2 v_uv;\n"
+    "in vec4 v_color;\n"
+    "uniform sampler2D u_atlas;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = vec4(v_color.rgb, v_color.a * texture(u_atlas, v_uv).r);\n"
+    "}\n";
+
+static int load_functions(gl3_api_t *gl, gl3_loader_t loader) {
+/* stored through void ** (the POSIX dlsym idiom) since ISO C has no object
+** to function pointer conversion */
+#define GL3_LOAD(type, name)                                                                       \
+    if (!(*(void **) &gl->name = loader("gl" #name))) {                                            \
+        fprintf(stderr, "GL3: missing entry point gl%s\n", #name);                                 \
+        return -1;                                                                                 \
+    }
+    GL3_FUNCTIONS(GL3_LOAD)
+#undef GL3_LOAD
+    return 0;
+}
+
+static GLuint compile_shader(gl3_renderer_t *r, GLenum type, const char *source) {
+    GLuint shader = r->gl.CreateShader(type);
+    GLint ok = 0;
+    r->gl.ShaderSource(shader, 1, &source, NULL);
+    r->gl.CompileShader(shader);
+    r->gl.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        r->gl.GetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "GL3: shader compilation failed: %s\n", log);
+        r->gl.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static int build_program(gl3_renderer_t *r) {
+    GLuint vs = compile_shader(r, GL_VERTEX_SHADER, vertex_source);
+    GLuint fs = compile_shader(r, GL_FRAGMENT_SHADER, fragment_source);
+    if (!vs || !fs) {
+        r->gl.DeleteShader(vs);
+        r->gl.DeleteShader(fs);
+        return -1;
+    }
+
+    GLint ok = 0;
+    r->program = r->gl.CreateProgram();
+    r->gl.AttachShader(r->program, vs);
+    r->gl.AttachShader(r->program, fs);
+    r->gl.LinkProgram(r->program);
+    r->gl.DeleteShader(vs);
+    r->gl.DeleteShader(fs);
+    r->gl.GetProgramiv(r->program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        r->gl.GetProgramInfoLog(r->program, sizeof(log), NULL, log);
+        fprintf(stderr, "GL3: program link failed: %s\n", log);
+        return -1;
+    }
+
+    r->gl.UseProgram(r->program);
+    r->viewport_loc = r->gl.GetUniformLocation(r->program, "u_viewport");
+    GLint atlas_size_loc = r->gl.GetUniformLocation(r->program, "u_atlas_size");
+    r->gl.Uniform2f(atlas_size_loc, GA_TEXTURE_WIDTH, GA_TEXTURE_HEIGHT);
+    r->gl.Uniform1i(r->gl.GetUniformLocation(r->program, "u_atlas"), 0);
+    return 0;
+}
+
+gl3_renderer_t *gl3_create(int width, int height, gl3_loader_t loader) {
+    gl3_renderer_t *r = calloc(1, sizeof(gl3_renderer_t));
+    if (!r) {
+        return NULL;
+    }
+    r->glyphs = ga_create(GA_MAX_PAGES);
+    if (!r->glyphs || load_functions(&r->gl, loader) != 0 || build_program(r) != 0) {
+        gl3_destroy(r);
+        return NULL;
+    }
+    r->width = width;
+    r->height = height;
+    r->clip = mu_rect(0, 0, width, height);
+
+    /* instance stream; attribute offsets are set per batch in flush() */
+    r->gl.GenVertexArrays(1, &r->vao);
+    r->gl.BindVertexArray(r->vao);
+    r->gl.GenBuffers(1, &r->vbo);
+    r->gl.BindBuffer(GL_ARRAY_BUFFER, r->vbo);
+    r->gl.BufferData(GL_ARRAY_BUFFER, GL3_RING_BYTES, NULL, GL_STREAM_DRAW);
+    for (GLuint i = 0; i < 3; i++) {
+        r->gl.EnableVertexAttribArray(i);
+        r->gl.VertexAttribDivisor(i, 1);
+    }
+
+    /* atlas, single channel; core profile has no GL_ALPHA textures. Glyphs
+    ** beyond ASCII are uploaded as they get packed */
+    glGenTextures(1, &r->texture);
+    r->gl.ActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, r->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(
+        GL_TEXTURE_2D,
+        0,
+        GL_R8,
+        GA_TEXTURE_WIDTH,
+        GA_TEXTURE_HEIGHT,
+        0,
+        GL_RED,
+        GL_UNSIGNED_BYTE,
+        ga_texture(r->glyphs)
+    );
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+
+    if (glGetError() != GL_NO_ERROR) {
+        fprintf(stderr, "GL3: renderer setup failed\n");
+        gl3_destroy(r);
+        return NULL;
+    }
+    return r;
+}
+
+void gl3_destroy(gl3_renderer_t *r) {
+    if (!r) {
+        return;
+    }
+    if (r->texture) {
+        glDeleteTextures(1, &r->texture);
+    }
+    if (r->vbo) {
+        r->gl.DeleteBuffers(1, &r->vbo);
+    }
+    if (r->vao) {
+        r->gl.DeleteVertexArrays(1, &r->vao);
+    }
+    if (r->program) {
+        r->gl.DeleteProgram(r->program);
+    }
+    ga_destroy(r->glyphs);
+    free(r);
+}
+
+void gl3_flush(gl3_renderer_t *r) {
+    if (r->count == 0) {
+        return;
+    }
+
+    trace_begin("flush");
+    mu_Rect dirty;
+    if (ga_take_dirty(r->glyphs, &dirty)) {
+        /* whole texture rows are contiguous in memory, so no unpack stride */
+        glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            0,
+            dirty.y,
+            GA_TEXTURE_WIDTH,
+            dirty.h,
+            GL_RED,
+            GL_UNSIGNED_BYTE,
+            ga_texture(r->glyphs) + dirty.y * GA_TEXTURE_WIDTH
+        );
+    }
+    size_t bytes = r->count * sizeof(gl3_instance_t);
+    if (r->ring_offset + bytes > GL3_RING_BYTES) {
+        /* orphan: the driver hands out fresh storage while the GPU may
+        ** still be reading the old one */
+        r->gl.BufferData(GL_ARRAY_BUFFER, GL3_RING_BYTES, NULL, GL_STREAM_DRAW);
+        r->ring_offset = 0;
+    }
+    void *dst = r->gl.MapBufferRange(
+        GL_ARRAY_BUFFER,
+        r->ring_offset,
+        bytes,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+    );
+    if (dst) {
+        memcpy(dst, r->instances, bytes);
+        r->gl.UnmapBuffer(GL_ARRAY_BUFFER);
+
+        const char *base = (const char *) (uintptr_t) r->ring_offset;
+        GLsizei stride = sizeof(gl3_instance_t);
+        r->gl.VertexAttribIPointer(0, 4, GL_SHORT, stride, base);
+        r->gl.VertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + 8);
+        r->gl.VertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, stride, base + 12);
+        r->gl.Uniform2f(r->viewport_loc, r->width, r->height);
+        glViewport(0, 0, r->width, r->height);
+        r->gl.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, r->count);
+        r->ring_offset += bytes;
+    }
+    r->count = 0;
+    trace_end("flush");
+}
+
+/* clips `dst` to the current clip rect; 1:1 atlas sources (glyphs, icons)
+** are trimmed by the same amount, stretched ones (the white patch) are
+** uniform and stay as they are */
+static void push_quad(gl3_renderer_t *r, mu_Rect dst, mu_Rect src, mu_Color color) {
+    int x0 = mu_max(dst.x, r->clip.x);
+    int y0 = mu_max(dst.y, r->clip.y);
+    int x1 = mu_min(dst.x + dst.w, r->clip.x + r->clip.w);
+    int y1 = mu_min(dst.y + dst.h, r->clip.y + r->clip.h);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+    if (src.w == dst.w && src.h == dst.h) {
+        src = mu_rect(src.x + x0 - dst.x, src.y + y0 - dst.y, x1 - x0, y1 - y0);
+    }
+    if (r->count == GL3_BATCH_INSTANCES) {
+        gl3_flush(r);
+    }
+    r->instances[r->count++] = (gl3_instance_t) {
+        x0, y0, x1 - x0, y1 - y0, color, src.x | (src.y >> 8) << 7, src.y & 0xff, src.w, src.h
+    };
+}
+
+void gl3_draw_rect(gl3_renderer_t *r, mu_Rect rect, mu_Color color) {
+    push_quad(r, rect, atlas[ATLAS_WHITE], color);
+}
+
+void gl3_draw_text(gl3_renderer_t *r, const char *text, int len, mu_Vec2 pos, mu_Color color) {
+    mu_Rect dst = {pos.x, pos.y, 0, 0};
+    if (len < 0) {
+        len = INT_MAX;
+    }
+    for (const char *p = text; p - text < len && *p;) {
+        mu_Rect src;
+        ga_next_glyph(r->glyphs, &p, len - (p - text), &src);
+        dst.w = src.w;
+        dst.h = src.h;
+        push_quad(r, dst, src, color);
+        dst.x += dst.w;
+    }
+}
+
+void gl3_draw_icon(gl3_renderer_t *r, int id, mu_Rect rect, mu_Color color) {
+    mu_Rect src = atlas[id];
+    int x = rect.x + (rect.w - src.w) / 2;
+    int y = rect.y + (rect.h - src.h) / 2;
+    push_quad(r, mu_rect(x, y, src.w, src.h), src, color);
+}
+
+void gl3_draw_columns(
+    gl3_renderer_t *r,
+    mu_Rect rect,
+    const unsigned short *spans,
+    mu_Color color
+) {
+    mu_Rect run;
+    for (int i = 0; mu_next_column_run(rect, spans, &i, &run);) {
+        gl3_draw_rect(r, run, color);
+    }
+}
+
+void gl3_draw_frame(
+    gl3_renderer_t *r,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+) {
+    mu_Rect rects[5];
+    mu_frame_rects(rect, border_width, rects);
+    gl3_draw_rect(r, rects[0], color);
+    for (int i = 1; i < 5; i++) {
+        gl3_draw_rect(r, rects[i], border);
+    }
+}
+
+void gl3_set_clip_rect(gl3_renderer_t *r, mu_Rect rect) {
+    /* also bounds coordinates to the viewport, keeping them in int16 range */
+    int x0 = mu_max(rect.x, 0);
+    int y0 = mu_max(rect.y, 0);
+    int x1 = mu_min(rect.x + rect.w, r->width);
+    int y1 = mu_min(rect.y + rect.h, r->height);
+    r->clip = mu_rect(x0, y0, mu_max(0, x1 - x0), mu_max(0, y1 - y0));
+}
+
+void gl3_clear(gl3_renderer_t *r, mu_Color clr) {
+    gl3_flush(r);
+    glClearColor(clr.r / 255., clr.g / 255., clr.b / 255., clr.a / 255.);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void gl3_render(gl3_renderer_t *r, mu_Context *ctx) {
+    mu_Command *cmd = NULL;
+    ga_begin_frame(r->glyphs);
+    while (mu_next_command(ctx, &cmd)) {
+        switch (cmd->type) {
+        case MU_COMMAND_TEXT:
+            gl3_draw_text(
+                r, mu_text_str(&cmd->text), cmd->text.len, cmd->text.pos, cmd->text.color
+            );
+            break;
+        case MU_COMMAND_RECT:
+            gl3_draw_rect(r, cmd->rect.rect, cmd->rect.color);
+            break;
+        case MU_COMMAND_ICON:
+            gl3_draw_icon(r, cmd->icon.id, cmd->icon.rect, cmd->icon.color);
+            break;
+        case MU_COMMAND_COLUMNS:
+            gl3_draw_columns(r, cmd->columns.rect, cmd->columns.spans, cmd->columns.color);
+            break;
+        case MU_COMMAND_FRAME:
+            gl3_draw_frame(
+                r, cmd->frame.rect, cmd->frame.color, cmd->frame.border, cmd->frame.border_width
+            );
+            break;
+        case MU_COMMAND_CLIP:
+            gl3_set_clip_rect(r, cmd->clip.rect);
+            break;
+        }
+    }
+}
@@ -0,0 +1,788 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "glyph_atlas.h"
+#include "atlas.inl"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define GA_X86 1
+#include <immintrin.h>
+// Blocks may be loaded past the terminator, though never across a page
+#define GA_TARGET(isa) __attribute__((target(isa), no_sanitize_address))
+#endif
+
+// Pages taken by the baked atlas; they are never evicted
+#define BAKED_PAGES (ATLAS_HEIGHT / GA_PAGE_HEIGHT)
+#define BOX_GLYPH 127
+#define GLYPH_MAX 32  // Largest glyph bitmap, in texels per side
+#define GLYPH_PAD 1   // Empty texels right of and below every packed glyph
+#define MAX_SHELVES 8 // Per page
+#define SLOT_BITS 10
+#define SLOT_COUNT (1 << SLOT_BITS)
+#define SHORT_RUN 16  // ASCII bytes measured inline before calling a kernel
+
+_Static_assert((int) ATLAS_WIDTH == (int) GA_PAGE_WIDTH, "baked atlas must span the page width");
+_Static_assert(ATLAS_HEIGHT % GA_PAGE_HEIGHT == 0, "baked atlas must fill whole pages");
+
+typedef struct
+{
+    int y, h; // Row band of the shelf
+    int x;    // Next free column
+} ga_shelf_t;
+
+typedef struct
+{
+    ga_shelf_t shelves[MAX_SHELVES];
+    int shelf_count;
+    unsigned stamp; // Frame the page was last used in
+} ga_page_t;
+
+typedef struct
+{
+    unsigned codepoint; // 0 marks an empty slot; ASCII is never cached
+    mu_Rect rect;
+    int page;
+} ga_glyph_t;
+
+struct glyph_atlas
+{
+    unsigned char texture[GA_TEXTURE_WIDTH * GA_TEXTURE_HEIGHT];
+    ga_page_t pages[GA_MAX_PAGES];
+    int page_count;
+    ga_glyph_t slots[SLOT_COUNT]; // Open addressing, linear probing
+    ga_glyph_t spare[SLOT_COUNT]; // Rehash buffer for evictions
+    unsigned frame;
+    unsigned epoch;
+    int dirty_x0, dirty_y0, dirty_x1, dirty_y1; // Empty when x0 >= x1
+    pthread_mutex_t lock;
+};
+
+/*============================================================================
+** decoding and metrics
+**============================================================================*/
+
+int ga_decode_utf8(const char *s, int len, unsigned *codepoint) {
+    const unsigned char *p = (const unsigned char *) s;
+    unsigned c = p[0];
+    unsigned min;
+    int n;
+    *codepoint = 0xfffd;
+    if (c < 0x80) {
+        *codepoint = c;
+        return 1;
+    }
+    if (c >= 0xc2 && c <= 0xdf) {
+        n = 2;
+        min = 0x80;
+        c &= 0x1f;
+    }
+    else if (c >= 0xe0 && c <= 0xef) {
+        n = 3;
+        min = 0x800;
+        c &= 0x0f;
+    }
+    else if (c >= 0xf0 && c <= 0xf4) {
+        n = 4;
+        min = 0x10000;
+        c &= 0x07;
+    }
+    else {
+        return 1;
+    }
+    if (n > len) {
+        return 1;
+    }
+    /* a terminator is no continuation byte, so this never reads past it */
+    for (int i = 1; i < n; i++) {
+        if ((p[i] & 0xc0) != 0x80) {
+            return 1;
+        }
+        c = c << 6 | (p[i] & 0x3f);
+    }
+    if (c < min || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) {
+        return 1;
+    }
+    *codepoint = c;
+    return n;
+}
+
+// Latin-1 letters U+00C0..U+00FF as a base letter and the mark drawn on
+// it ('-' for none); '?' has no base in the baked font
+static const char latin1_base[] =
+    "AAAAAA?CEEEEIIII?NOOOOO?OUUUUY??aaaaaa?ceeeeiiii?nooooo?ouuuuy?y";
+static const char latin1_mark[] =
+    "`'^~:o-,`'^:`'^:-~`'^~:-/`'^:'--`'^~:o-,`'^:`'^:-~`'^~:-/`'^:'-:";
+
+_Static_assert(sizeof(latin1_base) == 65 && sizeof(latin1_mark) == 65, "one entry per letter");
+
+/* returns the baked glyph `codepoint` is drawn from, with the mark to add */
+static int resolve(unsigned codepoint, char *mark) {
+    *mark = '-';
+    if (codepoint < 0x80) {
+        return codepoint;
+    }
+    if (codepoint >= 0xc0 && codepoint <= 0xff) {
+        int base = latin1_base[codepoint - 0xc0];
+        if (base == '?') {
+            return BOX_GLYPH;
+        }
+        *mark = latin1_mark[codepoint - 0xc0];
+        return base;
+    }
+    switch (codepoint) {
+    case 0xa0: /* no-break space */
+        return ' ';
+    case 0x2010: /* hyphens and dashes */
+    case 0x2011:
+    case 0x2012:
+    case 0x2013:
+    case 0x2014:
+    case 0x2212:
+        return '-';
+    case 0x2018: /* curly quotes */
+    case 0x2019:
+        return '\'';
+    case 0x201c:
+    case 0x201d:
+        return '"';
+    }
+    return BOX_GLYPH;
+}
+
+int ga_next_baked(const char **text, int len) {
+    unsigned char chr = **text;
+    if (chr < 0x80) {
+        (*text)++;
+        return chr;
+    }
+    unsigned codepoint;
+    char mark;
+    *text += ga_decode_utf8(*text, len, &codepoint);
+    return resolve(codepoint, &mark);
+}
+
+int ga_advance(unsigned codepoint) {
+    char mark;
+    return atlas[ATLAS_FONT + resolve(codepoint, &mark)].w;
+}
+
+int ga_text_width(const char *text, int len) {
+    const char *p = text;
+    int res = 0;
+    if (len < 0) {
+        len = INT_MAX;
+    }
+    while (len != 0 && *p) {
+        /* most labels end within a few bytes, where the kernels' setup
+        ** costs more than it saves; longer runs are handed over to them */
+        int n = 0, limit = mu_min(len, SHORT_RUN);
+        for (unsigned c; n < limit && (c = (unsigned char) p[n]) - 1u < 0x7f; n++) {
+            res += atlas[ATLAS_FONT + c].w;
+        }
+        if (n == SHORT_RUN && n < len && (unsigned char) p[n] - 1u < 0x7f) {
+            n += ga_ascii_run(p + n, len - n, &res, NULL);
+        }
+        p += n;
+        len -= n;
+        if (len == 0 || !*p) {
+            break;
+        }
+        unsigned codepoint;
+        n = ga_decode_utf8(p, len, &codepoint);
+        res += ga_advance(codepoint);
+        p += n;
+        len -= n;
+    }
+    return res;
+}
+
+/*============================================================================
+** ASCII run kernels
+**============================================================================*/
+
+typedef int (*ga_run_kernel_t)(const unsigned char *s, int len, int *x, int *offsets);
+
+// Advance of every ASCII glyph; rows of 16 double as shuffle tables
+static _Alignas(32) uint8_t ascii_width[128];
+static int ascii_width_max;
+static pthread_once_t ascii_width_once = PTHREAD_ONCE_INIT;
+static _Atomic ga_run_kernel_t run_kernel;
+
+static void init_ascii_width(void) {
+    for (int i = 0; i < 128; i++) {
+        ascii_width[i] = atlas[ATLAS_FONT + i].w;
+        ascii_width_max = mu_max(ascii_width_max, ascii_width[i]);
+    }
+}
+
+static int ascii_run_scalar(const unsigned char *s, int len, int *x, int *offsets) {
+    int n = 0, pos = *x;
+    /* 1..127; the terminator and bytes beyond ASCII end the run */
+    for (; n < len && s[n] - 1u < 0x7f; n++) {
+        if (offsets) {
+            offsets[n] = pos;
+        }
+        pos += ascii_width[s[n]];
+    }
+    *x = pos;
+    return n;
+}
+
+#ifdef GA_X86
+
+#define PAGE_BYTES 4096
+
+static inline int page_safe(const unsigned char *p, int block) {
+    return ((uintptr_t) p & (PAGE_BYTES - 1)) <= PAGE_BYTES - (uintptr_t) block;
+}
+
+/* advances of 16 bytes: one shuffle per table row of 16 glyphs. Bytes
+** outside the row are pushed to >= 0x80 by the saturating add, which the
+** shuffle reads as 0; control characters have no advance and are skipped */
+GA_TARGET("ssse3") static inline __m128i widths_ssse3(__m128i v) {
+    __m128i res = _mm_setzero_si128();
+    __m128i x = _mm_sub_epi8(v, _mm_set1_epi8(32));
+    for (int row = 2; row < 8; row++) {
+        __m128i table = _mm_load_si128((const __m128i *) (ascii_width + row * 16));
+        __m128i index = _mm_adds_epu8(x, _mm_set1_epi8(0x70));
+        res = _mm_or_si128(res, _mm_shuffle_epi8(table, index));
+        x = _mm_sub_epi8(x, _mm_set1_epi8(16));
+    }
+    return res;
+}
+
+/* exclusive prefix sum of 16 byte-sized advances; 16 glyphs of up to 15
+** texels can't overflow a byte */
+GA_TARGET("ssse3") static inline __m128i prefix_ssse3(__m128i w) {
+    __m128i sum = _mm_add_epi8(w, _mm_slli_si128(w, 1));
+    sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 2));
+    sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 4));
+    sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 8));
+    return _mm_sub_epi8(sum, w);
+}
+
+/* widens 16 byte offsets to ints on `base`; `room` is how many fit at `dst` */
+GA_TARGET("ssse3") static inline void
+store_offsets_ssse3(int *dst, __m128i bytes, int base, int run, int room) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i b = _mm_set1_epi32(base);
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    int tmp[16];
+    int *out = room >= 16 ? dst : tmp;
+    _mm_storeu_si128((__m128i *) out + 0, _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), b));
+    _mm_storeu_si128((__m128i *) out + 1, _mm_add_epi32(_mm_unpackhi_epi16(lo, zero), b));
+    _mm_storeu_si128((__m128i *) out + 2, _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), b));
+    _mm_storeu_si128((__m128i *) out + 3, _mm_add_epi32(_mm_unpackhi_epi16(hi, zero), b));
+    if (out == tmp) {
+        memcpy(dst, tmp, run * sizeof(int));
+    }
+}
+
+GA_TARGET("ssse3")
+static int ascii_run_ssse3(const unsigned char *s, int len, int *x, int *offsets) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    int n = 0, pos = *x;
+    while (n < len && page_safe(s + n, 16)) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (s + n));
+        int stop = _mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, zero)));
+        int run = mu_min(stop ? __builtin_ctz(stop) : 16, len - n);
+        __m128i w = _mm_and_si128(widths_ssse3(v), _mm_cmpgt_epi8(_mm_set1_epi8(run), lanes));
+        if (offsets) {
+            store_offsets_ssse3(offsets + n, prefix_ssse3(w), pos, run, len - n);
+        }
+        __m128i total = _mm_sad_epu8(w, zero);
+        pos += _mm_cvtsi128_si32(total) + _mm_extract_epi16(total, 4);
+        n += run;
+        if (run < 16) {
+            break;
+        }
+    }
+    *x = pos;
+    return n + ascii_run_scalar(s + n, len - n, x, offsets ? offsets + n : NULL);
+}
+
+GA_TARGET("avx2") static inline __m256i widths_avx2(__m256i v) {
+    __m256i res = _mm256_setzero_si256();
+    __m256i x = _mm256_sub_epi8(v, _mm256_set1_epi8(32));
+    for (int row = 2; row < 8; row++) {
+        __m128i row_table = _mm_load_si128((const __m128i *) (ascii_width + row * 16));
+        __m256i table = _mm256_broadcastsi128_si256(row_table);
+        __m256i index = _mm256_adds_epu8(x, _mm256_set1_epi8(0x70));
+        res = _mm256_or_si256(res, _mm256_shuffle_epi8(table, index));
+        x = _mm256_sub_epi8(x, _mm256_set1_epi8(16));
+    }
+    return res;
+}
+
+/* 32 advances as two lanes of 16; each lane is summed on its own */
+GA_TARGET("avx2") static inline __m256i prefix_avx2(__m256i w) {
+    __m256i sum = _mm256_add_epi8(w, _mm256_slli_si256(w, 1));
+    sum = _mm256_add_epi8(sum, _mm256_slli_si256(sum, 2));
+    sum = _mm256_add_epi8(sum, _mm256_slli_si256(sum, 4));
+    sum = _mm256_add_epi8(sum, _mm256_slli_si256(sum, 8));
+    return _mm256_sub_epi8(sum, w);
+}
+
+GA_TARGET("avx2") static void store_offsets_avx2(
+    int *dst, __m256i bytes, int base, int low_total, int run, int room
+) {
+    __m128i lo = _mm256_castsi256_si128(bytes);
+    __m128i hi = _mm256_extracti128_si256(bytes, 1);
+    __m256i b0 = _mm256_set1_epi32(base);
+    __m256i b1 = _mm256_set1_epi32(base + low_total);
+    int tmp[32];
+    int *out = room >= 32 ? dst : tmp;
+    _mm256_storeu_si256((__m256i *) out + 0, _mm256_add_epi32(_mm256_cvtepu8_epi32(lo), b0));
+    _mm256_storeu_si256(
+        (__m256i *) out + 1,
+        _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)), b0)
+    );
+    _mm256_storeu_si256((__m256i *) out + 2, _mm256_add_epi32(_mm256_cvtepu8_epi32(hi), b1));
+    _mm256_storeu_si256(
+        (__m256i *) out + 3,
+        _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)), b1)
+    );
+    if (out == tmp) {
+        memcpy(dst, tmp, run * sizeof(int));
+    }
+}
+
+GA_TARGET("avx2")
+static int ascii_run_avx2(const unsigned char *s, int len, int *x, int *offsets) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lanes = _mm256_setr_epi8(
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
+    );
+    int n = 0, pos = *x;
+    while (n < len && page_safe(s + n, 32)) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (s + n));
+        unsigned stop = _mm256_movemask_epi8(_mm256_or_si256(v, _mm256_cmpeq_epi8(v, zero)));
+        int run = mu_min(stop ? __builtin_ctz(stop) : 32, len - n);
+        __m256i keep = _mm256_cmpgt_epi8(_mm256_set1_epi8(run), lanes);
+        __m256i w = _mm256_and_si256(widths_avx2(v), keep);
+
+        /* four partial sums, two per lane */
+        __m256i sad = _mm256_sad_epu8(w, zero);
+        __m128i sums = _mm_add_epi64(
+            _mm256_castsi256_si128(sad),
+            _mm_srli_si128(_mm256_castsi256_si128(sad), 8)
+        );
+        __m128i high = _mm256_extracti128_si256(sad, 1);
+        int low_total = _mm_cvtsi128_si32(sums);
+        int high_total = _mm_cvtsi128_si32(_mm_add_epi64(high, _mm_srli_si128(high, 8)));
+        if (offsets) {
+            store_offsets_avx2(offsets + n, prefix_avx2(w), pos, low_total, run, len - n);
+        }
+        pos += low_total + high_total;
+        n += run;
+        if (run < 32) {
+            break;
+        }
+    }
+    *x = pos;
+    return n + ascii_run_scalar(s + n, len - n, x, offsets ? offsets + n : NULL);
+}
+
+#endif // GA_X86
+
+static int isa_supported(ga_isa_t isa) {
+    switch (isa) {
+    case GA_ISA_SCALAR:
+        return 1;
+#ifdef GA_X86
+    case GA_ISA_SSSE3:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+    case GA_ISA_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+static ga_run_kernel_t isa_kernel(ga_isa_t isa) {
+    switch (isa) {
+#ifdef GA_X86
+    case GA_ISA_SSSE3:
+        return ascii_run_ssse3;
+    case GA_ISA_AVX2:
+        return ascii_run_avx2;
+#endif
+    default:
+        return ascii_run_scalar;
+    }
+}
+
+ga_isa_t ga_set_isa(ga_isa_t isa) {
+    pthread_once(&ascii_width_once, init_ascii_width);
+    if (isa == GA_ISA_AUTO) {
+        isa = GA_ISA_AVX2;
+    }
+    /* the prefix sums hold 16 advances in a byte */
+    if (ascii_width_max > 15) {
+        isa = GA_ISA_SCALAR;
+    }
+    while (!isa_supported(isa)) {
+        isa--;
+    }
+    atomic_store(&run_kernel, isa_kernel(isa));
+    return isa;
+}
+
+const char *ga_isa_name(ga_isa_t isa) {
+    switch (isa) {
+    case GA_ISA_AUTO:
+        return "auto";
+    case GA_ISA_SCALAR:
+        return "scalar";
+    case GA_ISA_SSSE3:
+        return "ssse3";
+    case GA_ISA_AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+int ga_ascii_run(const char *text, int len, int *x, int *offsets) {
+    ga_run_kernel_t kernel = atomic_load_explicit(&run_kernel, memory_order_acquire);
+    if (!kernel) {
+        ga_set_isa(GA_ISA_AUTO);
+        kernel = atomic_load(&run_kernel);
+    }
+    return kernel((const unsigned char *) text, len, x, offsets);
+}
+
+/*============================================================================
+** glyph composition
+**============================================================================*/
+
+typedef struct
+{
+    char mark;
+    int w, h;
+    const char *rows; // '#' full, '+' half coverage
+} ga_mark_t;
+
+static const ga_mark_t marks[] = {
+    {'`', 2, 2, "#+ #"},
+    {'\'', 2, 2, "+## "},
+    {'^', 3, 2, " # # #"},
+    {'~', 4, 2, " # ## # "},
+    {':', 3, 1, "# #"},
+    {'o', 3, 3, " # # # # "},
+    {',', 2, 2, " ## "},
+};
+
+typedef struct
+{
+    int w, h;
+    unsigned char pixels[GLYPH_MAX * GLYPH_MAX];
+} ga_bitmap_t;
+
+/* first row with coverage, or `h` when the bitmap is empty */
+static int top_row(const ga_bitmap_t *b) {
+    for (int y = 0; y < b->h; y++) {
+        for (int x = 0; x < b->w; x++) {
+            if (b->pixels[y * GLYPH_MAX + x]) {
+                return y;
+            }
+        }
+    }
+    return b->h;
+}
+
+static int bottom_row(const ga_bitmap_t *b) {
+    for (int y = b->h - 1; y >= 0; y--) {
+        for (int x = 0; x < b->w; x++) {
+            if (b->pixels[y * GLYPH_MAX + x]) {
+                return y;
+            }
+        }
+    }
+    return -1;
+}
+
+static void load_baked(ga_bitmap_t *b, int chr) {
+    mu_Rect src = atlas[ATLAS_FONT + chr];
+    b->w = mu_min(src.w, GLYPH_MAX);
+    b->h = mu_min(src.h, GLYPH_MAX);
+    memset(b->pixels, 0, sizeof(b->pixels));
+    for (int y = 0; y < b->h; y++) {
+        memcpy(b->pixels + y * GLYPH_MAX, atlas_texture + (src.y + y) * ATLAS_WIDTH + src.x, b->w);
+    }
+}
+
+static void stamp_mark(ga_bitmap_t *b, const ga_mark_t *m, int x0, int y0) {
+    for (int y = 0; y < m->h; y++) {
+        for (int x = 0; x < m->w; x++) {
+            char c = m->rows[y * m->w + x];
+            int px = x0 + x, py = y0 + y;
+            if (c == ' ' || px < 0 || px >= b->w || py < 0 || py >= b->h) {
+                continue;
+            }
+            unsigned char *p = &b->pixels[py * GLYPH_MAX + px];
+            *p = mu_max(*p, c == '#' ? 255 : 128);
+        }
+    }
+}
+
+/* draws `base` from the baked font with `mark` added: diacritics above the
+** letter, a cedilla below it, a stroke across it */
+static void compose(ga_bitmap_t *b, int base, char mark) {
+    load_baked(b, base);
+    if (base == 'i') {
+        /* accents replace the dot, which sits above the x-height */
+        ga_bitmap_t x;
+        load_baked(&x, 'x');
+        memset(b->pixels, 0, top_row(&x) * GLYPH_MAX);
+    }
+    int top = top_row(b), bottom = bottom_row(b);
+    if (mark == '/') {
+        for (int y = top; y <= bottom && bottom > top; y++) {
+            int x = (bottom - y) * (b->w - 1) / (bottom - top);
+            b->pixels[y * GLYPH_MAX + x] = 255;
+        }
+        return;
+    }
+    for (size_t i = 0; i < sizeof(marks) / sizeof(marks[0]); i++) {
+        const ga_mark_t *m = &marks[i];
+        if (m->mark != mark) {
+            continue;
+        }
+        int x = (b->w - m->w + 1) / 2;
+        int y = mark == ',' ? bottom + 1 : mu_max(top - 1 - m->h, 0);
+        stamp_mark(b, m, x, y);
+    }
+}
+
+/*============================================================================
+** packing and eviction
+**============================================================================*/
+
+static unsigned slot_of(unsigned codepoint) {
+    return (codepoint * 2654435761u) >> (32 - SLOT_BITS);
+}
+
+static ga_glyph_t *find_slot(ga_glyph_t *slots, unsigned codepoint) {
+    unsigned i = slot_of(codepoint);
+    while (slots[i].codepoint && slots[i].codepoint != codepoint) {
+        i = (i + 1) & (SLOT_COUNT - 1);
+    }
+    return &slots[i];
+}
+
+/* finds room for a w x h glyph on `page`; returns 0 when it is full */
+static int pack(ga_page_t *page, int w, int h, int *x, int *y) {
+    w += GLYPH_PAD;
+    h += GLYPH_PAD;
+    for (int i = 0; i < page->shelf_count; i++) {
+        ga_shelf_t *s = &page->shelves[i];
+        if (h <= s->h && s->x + w <= GA_PAGE_WIDTH) {
+            *x = s->x;
+            *y = s->y;
+            s->x += w;
+            return 1;
+        }
+    }
+    int next = 0;
+    if (page->shelf_count > 0) {
+        ga_shelf_t *last = &page->shelves[page->shelf_count - 1];
+        next = last->y + last->h;
+    }
+    if (page->shelf_count == MAX_SHELVES || next + h > GA_PAGE_HEIGHT || w > GA_PAGE_WIDTH) {
+        return 0;
+    }
+    page->shelves[page->shelf_count++] = (ga_shelf_t) {next, h, w};
+    *x = 0;
+    *y = next;
+    return 1;
+}
+
+/* empties the least recently used page not used this frame; returns its
+** index, or -1 when every page is in use */
+static int evict(glyph_atlas_t *ga) {
+    int victim = -1;
+    for (int i = BAKED_PAGES; i < ga->page_count; i++) {
+        ga_page_t *page = &ga->pages[i];
+        if (page->stamp != ga->frame && (victim < 0 || page->stamp < ga->pages[victim].stamp)) {
+            victim = i;
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+    ga->pages[victim].shelf_count = 0;
+
+    /* drop its glyphs; rehashing keeps the probe chains intact */
+    memcpy(ga->spare, ga->slots, sizeof(ga->slots));
+    memset(ga->slots, 0, sizeof(ga->slots));
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        if (ga->spare[i].codepoint && ga->spare[i].page != victim) {
+            *find_slot(ga->slots, ga->spare[i].codepoint) = ga->spare[i];
+        }
+    }
+    ga->epoch++;
+    return victim;
+}
+
+static void mark_dirty(glyph_atlas_t *ga, mu_Rect r) {
+    if (ga->dirty_x0 >= ga->dirty_x1) {
+        ga->dirty_x0 = r.x;
+        ga->dirty_y0 = r.y;
+        ga->dirty_x1 = r.x + r.w;
+        ga->dirty_y1 = r.y + r.h;
+        return;
+    }
+    ga->dirty_x0 = mu_min(ga->dirty_x0, r.x);
+    ga->dirty_y0 = mu_min(ga->dirty_y0, r.y);
+    ga->dirty_x1 = mu_max(ga->dirty_x1, r.x + r.w);
+    ga->dirty_y1 = mu_max(ga->dirty_y1, r.y + r.h);
+}
+
+/* packs `b` into the first page with room, evicting one when all are full;
+** returns the page, or -1 */
+static int place(glyph_atlas_t *ga, const ga_bitmap_t *b, mu_Rect *rect) {
+    int x, y, page = -1;
+    for (int i = BAKED_PAGES; i < ga->page_count && page < 0; i++) {
+        if (pack(&ga->pages[i], b->w, b->h, &x, &y)) {
+            page = i;
+        }
+    }
+    if (page < 0) {
+        page = evict(ga);
+        if (page < 0 || !pack(&ga->pages[page], b->w, b->h, &x, &y)) {
+            return -1;
+        }
+    }
+
+    /* the padding is written too, as the page may hold an evicted glyph */
+    *rect = mu_rect(x, page * GA_PAGE_HEIGHT + y, b->w, b->h);
+    int w = mu_min(b->w + GLYPH_PAD, GA_PAGE_WIDTH - x);
+    int h = mu_min(b->h + GLYPH_PAD, GA_PAGE_HEIGHT - y);
+    for (int row = 0; row < h; row++) {
+        unsigned char *dst = ga->texture + (rect->y + row) * GA_TEXTURE_WIDTH + x;
+        memset(dst, 0, w);
+        if (row < b->h) {
+            memcpy(dst, b->pixels + row * GLYPH_MAX, b->w);
+        }
+    }
+    mark_dirty(ga, mu_rect(x, rect->y, w, h));
+    return page;
+}
+
+/*============================================================================
+** atlas
+**============================================================================*/
+
+glyph_atlas_t *ga_create(int pages) {
+    glyph_atlas_t *ga = calloc(1, sizeof(glyph_atlas_t));
+    if (!ga) {
+        return NULL;
+    }
+    ga->page_count = mu_clamp(pages, BAKED_PAGES, GA_MAX_PAGES);
+    ga->frame = 1;
+    memcpy(ga->texture, atlas_texture, sizeof(atlas_texture));
+    pthread_mutex_init(&ga->lock, NULL);
+    return ga;
+}
+
+void ga_destroy(glyph_atlas_t *ga) {
+    if (!ga) {
+        return;
+    }
+    pthread_mutex_destroy(&ga->lock);
+    free(ga);
+}
+
+const unsigned char *ga_texture(const glyph_atlas_t *ga) {
+    return ga->texture;
+}
+
+void ga_begin_frame(glyph_atlas_t *ga) {
+    pthread_mutex_lock(&ga->lock);
+    ga->frame++;
+    pthread_mutex_unlock(&ga->lock);
+}
+
+int ga_lookup(glyph_atlas_t *ga, unsigned codepoint, mu_Rect *src) {
+    char mark;
+    int base = resolve(codepoint, &mark);
+    if (mark == '-') {
+        *src = atlas[ATLAS_FONT + base];
+        return src->y / GA_PAGE_HEIGHT;
+    }
+
+    pthread_mutex_lock(&ga->lock);
+    ga_glyph_t *slot = find_slot(ga->slots, codepoint);
+    if (!slot->codepoint) {
+        ga_bitmap_t b;
+        compose(&b, base, mark);
+        mu_Rect rect;
+        int page = place(ga, &b, &rect);
+        if (page < 0) {
+            pthread_mutex_unlock(&ga->lock);
+            *src = atlas[ATLAS_FONT + base];
+            return src->y / GA_PAGE_HEIGHT;
+        }
+        /* an eviction rehashes, so the slot is looked up again */
+        slot = find_slot(ga->slots, codepoint);
+        *slot = (ga_glyph_t) {codepoint, rect, page};
+    }
+    ga->pages[slot->page].stamp = ga->frame;
+    *src = slot->rect;
+    int page = slot->page;
+    pthread_mutex_unlock(&ga->lock);
+    return page;
+}
+
+int ga_next_glyph(glyph_atlas_t *ga, const char **text, int len, mu_Rect *src) {
+    unsigned char chr = **text;
+    if (chr < 0x80 || !ga) {
+        *src = atlas[ATLAS_FONT + ga_next_baked(text, len)];
+        return src->y / GA_PAGE_HEIGHT;
+    }
+    unsigned codepoint;
+    *text += ga_decode_utf8(*text, len, &codepoint);
+    return ga_lookup(ga, codepoint, src);
+}
+
+void ga_touch_pages(glyph_atlas_t *ga, unsigned pages) {
+    pthread_mutex_lock(&ga->lock);
+    for (int i = BAKED_PAGES; i < ga->page_count; i++) {
+        if (pages & 1u << i) {
+            ga->pages[i].stamp = ga->frame;
+        }
+    }
+    pthread_mutex_unlock(&ga->lock);
+}
+
+unsigned ga_epoch(const glyph_atlas_t *ga) {
+    return ga->epoch;
+}
+
+int ga_take_dirty(glyph_atlas_t *ga, mu_Rect *rect) {
+    pthread_mutex_lock(&ga->lock);
+    int dirty = ga->dirty_x0 < ga->dirty_x1;
+    if (dirty) {
+        *rect = mu_rect(
+            ga->dirty_x0,
+            ga->dirty_y0,
+            ga->dirty_x1 - ga->dirty_x0,
+            ga->dirty_y1 - ga->dirty_y0
+        );
+        ga->dirty_x0 = ga->dirty_x1 = 0;
+    }
+    pthread_mutex_unlock(&ga->lock);
+    return dirty;
+}
@@ -1,5 +1,6 @@
 #include "client.h"
 #include "server.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -15,8 +16,23 @@ static int help_command_run(int argc, char **argv, char **envp) {
     printf("  %s    Run the client\n", CLIENT_COMMAND);
     printf("  %s    Run the server\n", SERVER_COMMAND);
     printf("  %s      Show this help message\n", HELP_COMMAND);
+    printf("\nClient options:\n");
+    printf("  --headless              Run without a window or GPU and report frame timings\n");
+    printf("  --mode <name>           Renderer: window, gl3, software or null (default window)\n");
+    printf("  --config <file>         Read the client mode and size from a JSON config file\n");
+    printf("  --frames <n>            Stop after <n> frames\n");
+    printf("  --vertex-threads <n>    Generate vertices on <n> threads for dense frames\n");
+    printf("  --vertex-min-quads <n>  Only go parallel above <n> quads (default 8192)\n");
+    printf("  --replay <file>         Drive a headless run from recorded input\n");
+    printf("  --record <file>         Record window input for later replay\n");
+    printf("  --screenshot <file>     Save the last headless frame as a PPM image\n");
+    printf("\nEnvironment:\n");
+    printf("  %s=<file>    Write a Chrome trace-event JSON session to <file>\n", TRACE_ENV);
+    printf("  LIBGL_ALWAYS_SOFTWARE=1  Run the gl3 mode on Mesa's llvmpipe without a GPU\n");
     printf("\nExamples:\n");
     printf("  %s %s\n", program, CLIENT_COMMAND);
+    printf("  %s %s --headless --frames 500\n", program, CLIENT_COMMAND);
+    printf("  %s %s --mode software --screenshot frame.ppm\n", program, CLIENT_COMMAND);
     printf("  %s %s\n", program, SERVER_COMMAND);
     printf("  %s %s\n", program, HELP_COMMAND);
     return 0;
@@ -38,6 +54,10 @@ int main(int argc, char **argv, char **envp) {
 
     const char *command = argv[1];
 
+    if (trace_init_from_env() == 0) {
+        trace_set_thread_name("main");
+    }
+
     if (strcmp(command, HELP_COMMAND) == 0) {
         return help_command_run(argc, argv, envp);
     }
@@ -25,6 +25,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define unused(x) ((void) (x))
 
 #define expect(x)                                                                                  \
@@ -54,7 +58,21 @@
         (stk).idx--;                                                                               \
     } while (0)
 
+#ifdef MU_FRAME_STATS
+#define stat_add(ctx, field, n)                                                                    \
+    do {                                                                                           \
+        (ctx)->frame_stats.total.field += (n);                                                     \
+        if ((ctx)->stats_root >= 0) {                                                              \
+            (ctx)->frame_stats.roots[(ctx)->stats_root].counters.field += (n);                     \
+        }                                                                                          \
+    } while (0)
+#else
+#define stat_add(ctx, field, n) ((void) 0)
+#endif
+
 static mu_Rect unclipped_rect = {0, 0, 0x1000000, 0x1000000};
+/* clip base of recorded scroll panel content, which may be replayed anywhere */
+static mu_Rect retained_rect = {-0x400000, -0x400000, 0x800000, 0x800000};
 
 static mu_Style default_style = {
     /* font | size | padding | spacing | indent */
@@ -114,6 +132,22 @@ static mu_Rect expand_rect(mu_Rect rect, int n) {
     return mu_rect(rect.x - n, rect.y - n, rect.w + n * 2, rect.h + n * 2);
 }
 
+static mu_Rect union_rects(mu_Rect r1, mu_Rect r2) {
+    int x1, y1, x2, y2;
+    if (r1.w <= 0 || r1.h <= 0) {
+        return r2;
+    }
+    x1 = mu_min(r1.x, r2.x);
+    y1 = mu_min(r1.y, r2.y);
+    x2 = mu_max(r1.x + r1.w, r2.x + r2.w);
+    y2 = mu_max(r1.y + r1.h, r2.y + r2.h);
+    return mu_rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+static mu_Rect move_rect(mu_Rect r, mu_Vec2 delta) {
+    return mu_rect(r.x + delta.x, r.y + delta.y, r.w, r.h);
+}
+
 static mu_Rect intersect_rects(mu_Rect r1, mu_Rect r2) {
     int x1 = mu_max(r1.x, r2.x);
     int y1 = mu_max(r1.y, r2.y);
@@ -132,16 +166,20 @@ static int rect_overlaps_vec2(mu_Rect r, mu_Vec2 p) {
     return p.x >= r.x && p.x < r.x + r.w && p.y >= r.y && p.y < r.y + r.h;
 }
 
+static int text_width(mu_Context *ctx, mu_Font font, const char *str, int len) {
+    stat_add(ctx, text_width_calls, 1);
+    return ctx->text_width(font, str, len);
+}
+
 static void draw_frame(mu_Context *ctx, mu_Rect rect, int colorid) {
-    mu_draw_rect(ctx, rect, ctx->style->colors[colorid]);
+    mu_Color border = ctx->style->colors[MU_COLOR_BORDER];
     if (colorid == MU_COLOR_SCROLLBASE || colorid == MU_COLOR_SCROLLTHUMB ||
-        colorid == MU_COLOR_TITLEBG) {
+        colorid == MU_COLOR_TITLEBG || !border.a) {
+        mu_draw_rect(ctx, rect, ctx->style->colors[colorid]);
         return;
     }
-    /* draw border */
-    if (ctx->style->colors[MU_COLOR_BORDER].a) {
-        mu_draw_box(ctx, expand_rect(rect, 1), ctx->style->colors[MU_COLOR_BORDER]);
-    }
+    /* with a border around it */
+    mu_draw_frame(ctx, expand_rect(rect, 1), ctx->style->colors[colorid], border, 1);
 }
 
 void mu_init(mu_Context *ctx) {
@@ -161,8 +199,17 @@ void mu_begin(mu_Context *ctx) {
     ctx->mouse_delta.x = ctx->mouse_pos.x - ctx->last_mouse_pos.x;
     ctx->mouse_delta.y = ctx->mouse_pos.y - ctx->last_mouse_pos.y;
     ctx->frame++;
+    ctx->retained_list[ctx->frame & 1].idx = 0;
+#ifdef MU_FRAME_STATS
+    memset(&ctx->frame_stats, 0, sizeof(ctx->frame_stats));
+    ctx->frame_stats.frame = ctx->frame;
+    ctx->stats_root = -1;
+#endif
 }
 
+static int cull_occluded(mu_Context *ctx);
+static int optimize_commands(mu_Context *ctx);
+
 static int compare_zindex(const void *a, const void *b) {
     return (*(mu_Container **) a)->zindex - (*(mu_Container **) b)->zindex;
 }
@@ -174,6 +221,7 @@ void mu_end(mu_Context *ctx) {
     expect(ctx->clip_stack.idx == 0);
     expect(ctx->id_stack.idx == 0);
     expect(ctx->layout_stack.idx == 0);
+    expect(ctx->cached_depth == 0);
 
     /* handle scroll input */
     if (ctx->scroll_target) {
@@ -203,6 +251,11 @@ void mu_end(mu_Context *ctx) {
     /* sort root containers by zindex */
     n = ctx->root_list.idx;
     qsort(ctx->root_list.items, n, sizeof(mu_Container *), compare_zindex);
+    ctx->dropped_commands = ctx->culled_roots = 0;
+    if (ctx->cull_occluded) {
+        ctx->dropped_commands = cull_occluded(ctx);
+        n = ctx->root_list.idx;
+    }
 
     /* set root container jump commands */
     for (i = 0; i < n; i++) {
@@ -222,6 +275,10 @@ void mu_end(mu_Context *ctx) {
             cnt->tail->jump.dst = ctx->command_list.items + ctx->command_list.idx;
         }
     }
+
+    if (ctx->optimize_commands) {
+        ctx->dropped_commands += optimize_commands(ctx);
+    }
 }
 
 void mu_set_focus(mu_Context *ctx, mu_Id id) {
@@ -229,24 +286,72 @@ void mu_set_focus(mu_Context *ctx, mu_Id id) {
     ctx->updated_focus = 1;
 }
 
-/* 32bit fnv-1a hash */
-#define HASH_INITIAL 2166136261
+/* words are assembled from bytes, so ids don't depend on the byte order */
+static unsigned long long load_word(const unsigned char *p, int size) {
+    unsigned long long res = 0;
+    if (size == 8) {
+        memcpy(&res, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        res = __builtin_bswap64(res);
+#endif
+        return res;
+    }
+    while (size--) {
+        res |= (unsigned long long) p[size] << size * 8;
+    }
+    return res;
+}
 
-static void hash(mu_Id *hash, const void *data, int size) {
+/* must match MU_HASH_LITERAL */
+mu_Id mu_hash(const void *data, int size) {
     const unsigned char *p = data;
-    while (size--) {
-        *hash = (*hash ^ *p++) * 16777619;
+    unsigned long long h = MU_HASH_SEED ^ size;
+    for (; size >= 8; p += 8, size -= 8) {
+        h = mu_hash_step_(h, load_word(p, 8));
     }
+    if (size > 0) {
+        h = mu_hash_step_(h, load_word(p, size));
+    }
+    return (mu_Id) h;
 }
 
-mu_Id mu_get_id(mu_Context *ctx, const void *data, int size) {
+/* the data is hashed on its own and then into the enclosing id, so the first
+** step can be done once for interned labels and literals */
+mu_Id mu_get_hash_id(mu_Context *ctx, mu_Id hash) {
     int idx = ctx->id_stack.idx;
-    mu_Id res = (idx > 0) ? ctx->id_stack.items[idx - 1] : HASH_INITIAL;
-    hash(&res, data, size);
+    unsigned long long parent = (idx > 0) ? ctx->id_stack.items[idx - 1] : 0;
+    mu_Id res = (mu_Id) mu_hash_step_(MU_HASH_SEED, parent << 32 | hash);
     ctx->last_id = res;
     return res;
 }
 
+mu_Id mu_get_id(mu_Context *ctx, const void *data, int size) {
+    return mu_get_hash_id(ctx, mu_hash(data, size));
+}
+
+mu_Label mu_intern_label(const char *str) {
+    mu_Label res;
+    res.str = str;
+    res.len = strlen(str);
+    res.hash = mu_hash(str, res.len);
+    res.font = NULL;
+    res.width = -1;
+    return res;
+}
+
+mu_Id mu_get_label_id(mu_Context *ctx, const mu_Label *label) {
+    return mu_get_hash_id(ctx, label->hash);
+}
+
+static int label_width(mu_Context *ctx, mu_Label *label) {
+    mu_Font font = ctx->style->font;
+    if (label->width < 0 || label->font != font) {
+        label->width = text_width(ctx, font, label->str, label->len);
+        label->font = font;
+    }
+    return label->width;
+}
+
 void mu_push_id(mu_Context *ctx, const void *data, int size) {
     push(ctx->id_stack, mu_get_id(ctx, data, size));
 }
@@ -257,6 +362,7 @@ void mu_pop_id(mu_Context *ctx) {
 
 void mu_push_clip_rect(mu_Context *ctx, mu_Rect rect) {
     mu_Rect last = mu_get_clip_rect(ctx);
+    stat_add(ctx, clip_pushes, 1);
     push(ctx->clip_stack, intersect_rects(rect, last));
 }
 
@@ -269,8 +375,7 @@ mu_Rect mu_get_clip_rect(mu_Context *ctx) {
     return ctx->clip_stack.items[ctx->clip_stack.idx - 1];
 }
 
-int mu_check_clip(mu_Context *ctx, mu_Rect r) {
-    mu_Rect cr = mu_get_clip_rect(ctx);
+static int check_clip(mu_Rect r, mu_Rect cr) {
     if (r.x > cr.x + cr.w || r.x + r.w < cr.x || r.y > cr.y + cr.h || r.y + r.h < cr.y) {
         return MU_CLIP_ALL;
     }
@@ -280,6 +385,10 @@ int mu_check_clip(mu_Context *ctx, mu_Rect r) {
     return MU_CLIP_PART;
 }
 
+int mu_check_clip(mu_Context *ctx, mu_Rect r) {
+    return check_clip(r, mu_get_clip_rect(ctx));
+}
+
 static void push_layout(mu_Context *ctx, mu_Rect body, mu_Vec2 scroll) {
     mu_Layout layout;
     int width = 0;
@@ -328,6 +437,7 @@ static mu_Container *get_container(mu_Context *ctx, mu_Id id, int opt) {
     cnt = &ctx->containers[idx];
     memset(cnt, 0, sizeof(*cnt));
     cnt->open = 1;
+    cnt->retained.frame = -1;
     mu_bring_to_front(ctx, cnt);
     return cnt;
 }
@@ -341,6 +451,12 @@ void mu_bring_to_front(mu_Context *ctx, mu_Container *cnt) {
     cnt->zindex = ++ctx->last_zindex;
 }
 
+#ifdef MU_FRAME_STATS
+const mu_FrameStats *mu_get_frame_stats(mu_Context *ctx) {
+    return &ctx->frame_stats;
+}
+#endif
+
 /*============================================================================
 ** pool
 **============================================================================*/
@@ -354,6 +470,9 @@ int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
         }
     }
     expect(n > -1);
+    if (items[n].id) {
+        stat_add(ctx, pool_evictions, 1);
+    }
     items[n].id = id;
     mu_pool_update(ctx, items, n);
     return n;
@@ -362,6 +481,7 @@ int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
 int mu_pool_get(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
     int i;
     unused(ctx);
+    stat_add(ctx, pool_lookups, 1);
     for (i = 0; i < len; i++) {
         if (items[i].id == id) {
             return i;
@@ -424,9 +544,28 @@ mu_Command *mu_push_command(mu_Context *ctx, int type, int size) {
     cmd->base.type = type;
     cmd->base.size = size;
     ctx->command_list.idx += size;
+    stat_add(ctx, commands, 1);
+    stat_add(ctx, command_bytes, size);
     return cmd;
 }
 
+/* counts commands added to or dropped from the list in bulk, by `sign` */
+static void stat_commands(mu_Context *ctx, const char *src, int size, int sign) {
+#ifdef MU_FRAME_STATS
+    const char *end = src + size;
+    for (; src < end; src += ((const mu_Command *) src)->base.size) {
+        stat_add(ctx, commands, sign);
+        stat_add(ctx, clip_commands, sign * (((const mu_Command *) src)->type == MU_COMMAND_CLIP));
+    }
+    stat_add(ctx, command_bytes, sign * size);
+#else
+    unused(ctx);
+    unused(src);
+    unused(size);
+    unused(sign);
+#endif
+}
+
 int mu_next_command(mu_Context *ctx, mu_Command **cmd) {
     if (*cmd) {
         *cmd = (mu_Command *) (((char *) *cmd) + (*cmd)->base.size);
@@ -454,6 +593,7 @@ void mu_set_clip(mu_Context *ctx, mu_Rect rect) {
     mu_Command *cmd;
     cmd = mu_push_command(ctx, MU_COMMAND_CLIP, sizeof(mu_ClipCommand));
     cmd->clip.rect = rect;
+    stat_add(ctx, clip_commands, 1);
 }
 
 void mu_draw_rect(mu_Context *ctx, mu_Rect rect, mu_Color color) {
@@ -479,23 +619,55 @@ void mu_draw_text(
     int len,
     mu_Vec2 pos,
     mu_Color color
+) {
+    mu_draw_text_ex(ctx, font, str, len, pos, color, 0);
+}
+
+/* sets the clip rect for drawing `rect` if it's only partly visible, and
+** returns how it is clipped */
+static int begin_clip(mu_Context *ctx, mu_Rect rect) {
+    mu_Rect cr = mu_get_clip_rect(ctx);
+    int clipped = check_clip(rect, cr);
+    /* recorded content keeps inner clip rects for when it's moved */
+    if (!clipped && ctx->retaining && memcmp(&cr, &retained_rect, sizeof(mu_Rect))) {
+        clipped = MU_CLIP_PART;
+    }
+    if (clipped == MU_CLIP_PART) {
+        mu_set_clip(ctx, cr);
+    }
+    return clipped;
+}
+
+/* `width` is the text's, already measured by the caller */
+static void draw_text(
+    mu_Context *ctx,
+    mu_Font font,
+    const char *str,
+    int len,
+    int width,
+    mu_Vec2 pos,
+    mu_Color color,
+    int opt
 ) {
     mu_Command *cmd;
-    mu_Rect rect = mu_rect(pos.x, pos.y, ctx->text_width(font, str, len), ctx->text_height(font));
-    int clipped = mu_check_clip(ctx, rect);
+    mu_Rect rect = mu_rect(pos.x, pos.y, width, ctx->text_height(font));
+    int clipped = begin_clip(ctx, rect);
     if (clipped == MU_CLIP_ALL) {
         return;
     }
-    if (clipped == MU_CLIP_PART) {
-        mu_set_clip(ctx, mu_get_clip_rect(ctx));
-    }
     /* add command */
-    if (len < 0) {
-        len = strlen(str);
+    if (opt & MU_OPT_NOCOPY) {
+        cmd = mu_push_command(ctx, MU_COMMAND_TEXT, sizeof(mu_TextCommand));
+        cmd->text.ref = str;
+        cmd->text.str[0] = '\0';
     }
-    cmd = mu_push_command(ctx, MU_COMMAND_TEXT, sizeof(mu_TextCommand) + len);
-    memcpy(cmd->text.str, str, len);
-    cmd->text.str[len] = '\0';
+    else {
+        cmd = mu_push_command(ctx, MU_COMMAND_TEXT, sizeof(mu_TextCommand) + len);
+        cmd->text.ref = NULL;
+        memcpy(cmd->text.str, str, len);
+        cmd->text.str[len] = '\0';
+    }
+    cmd->text.len = len;
     cmd->text.pos = pos;
     cmd->text.color = color;
     cmd->text.font = font;
@@ -505,16 +677,28 @@ void mu_draw_text(
     }
 }
 
+void mu_draw_text_ex(
+    mu_Context *ctx,
+    mu_Font font,
+    const char *str,
+    int len,
+    mu_Vec2 pos,
+    mu_Color color,
+    int opt
+) {
+    if (len < 0) {
+        len = strlen(str);
+    }
+    draw_text(ctx, font, str, len, text_width(ctx, font, str, len), pos, color, opt);
+}
+
 void mu_draw_icon(mu_Context *ctx, int id, mu_Rect rect, mu_Color color) {
     mu_Command *cmd;
     /* do clip command if the rect isn't fully contained within the cliprect */
-    int clipped = mu_check_clip(ctx, rect);
+    int clipped = begin_clip(ctx, rect);
     if (clipped == MU_CLIP_ALL) {
         return;
     }
-    if (clipped == MU_CLIP_PART) {
-        mu_set_clip(ctx, mu_get_clip_rect(ctx));
-    }
     /* do icon command */
     cmd = mu_push_command(ctx, MU_COMMAND_ICON, sizeof(mu_IconCommand));
     cmd->icon.id = id;
@@ -526,6 +710,58 @@ void mu_draw_icon(mu_Context *ctx, int id, mu_Rect rect, mu_Color color) {
     }
 }
 
+void mu_draw_frame(
+    mu_Context *ctx,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+) {
+    int w = border_width, i;
+    mu_Rect rects[5];
+    mu_Command *cmd;
+    /* renderers don't clip frames, so clipped ones are drawn as rects */
+    if (!ctx->frame_commands || check_clip(rect, mu_get_clip_rect(ctx))) {
+        mu_frame_rects(rect, w, rects);
+        mu_draw_rect(ctx, rects[0], color);
+        for (i = 1; i < 5; i++) {
+            mu_draw_rect(ctx, rects[i], border);
+        }
+        return;
+    }
+    cmd = mu_push_command(ctx, MU_COMMAND_FRAME, sizeof(mu_FrameCommand));
+    cmd->frame.rect = rect;
+    cmd->frame.color = color;
+    cmd->frame.border = border;
+    cmd->frame.border_width = w;
+}
+
+void mu_frame_rects(mu_Rect rect, int border_width, mu_Rect *rects) {
+    int w = border_width;
+    rects[0] = expand_rect(rect, -w);
+    rects[1] = mu_rect(rect.x + w, rect.y, rect.w - w * 2, w);
+    rects[2] = mu_rect(rect.x + w, rect.y + rect.h - w, rect.w - w * 2, w);
+    rects[3] = mu_rect(rect.x, rect.y, w, rect.h);
+    rects[4] = mu_rect(rect.x + rect.w - w, rect.y, w, rect.h);
+}
+
+int mu_next_column_run(mu_Rect rect, const unsigned short *spans, int *index, mu_Rect *run) {
+    int i = *index, j, top, bottom;
+    while (i < rect.w) {
+        top = spans[i * 2];
+        bottom = spans[i * 2 + 1];
+        for (j = i + 1; j < rect.w && spans[j * 2] == top && spans[j * 2 + 1] == bottom; j++) {}
+        if (top < bottom) {
+            *run = mu_rect(rect.x + i, rect.y + top, j - i, bottom - top);
+            *index = j;
+            return 1;
+        }
+        i = j;
+    }
+    *index = i;
+    return 0;
+}
+
 /*============================================================================
 ** layout
 **============================================================================*/
@@ -633,6 +869,10 @@ mu_Rect mu_layout_next(mu_Context *ctx) {
     layout->max.x = mu_max(layout->max.x, res.x + res.w);
     layout->max.y = mu_max(layout->max.y, res.y + res.h);
 
+    if (ctx->caching) {
+        ctx->caching->bounds = union_rects(ctx->caching->bounds, res);
+    }
+
     return (ctx->last_rect = res);
 }
 
@@ -663,10 +903,17 @@ void mu_draw_control_frame(mu_Context *ctx, mu_Id id, mu_Rect rect, int colorid,
     ctx->draw_frame(ctx, rect, colorid);
 }
 
-void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect, int colorid, int opt) {
+static void draw_control_text(
+    mu_Context *ctx,
+    const char *str,
+    int len,
+    int tw,
+    mu_Rect rect,
+    int colorid,
+    int opt
+) {
     mu_Vec2 pos;
     mu_Font font = ctx->style->font;
-    int tw = ctx->text_width(font, str, -1);
     mu_push_clip_rect(ctx, rect);
     pos.y = rect.y + (rect.h - ctx->text_height(font)) / 2;
     if (opt & MU_OPT_ALIGNCENTER) {
@@ -678,11 +925,48 @@ void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect, int co
     else {
         pos.x = rect.x + ctx->style->padding;
     }
-    mu_draw_text(ctx, font, str, -1, pos, ctx->style->colors[colorid]);
+    draw_text(ctx, font, str, len, tw, pos, ctx->style->colors[colorid], opt & MU_OPT_NOCOPY);
     mu_pop_clip_rect(ctx);
 }
 
+void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect, int colorid, int opt) {
+    int len = strlen(str);
+    int tw = text_width(ctx, ctx->style->font, str, len);
+    draw_control_text(ctx, str, len, tw, rect, colorid, opt);
+}
+
+static void draw_label(mu_Context *ctx, mu_Label *label, mu_Rect rect, int colorid, int opt) {
+    draw_control_text(ctx, label->str, label->len, label_width(ctx, label), rect, colorid, opt);
+}
+
+/* copies `size` bytes to this frame's retained list and returns their
+** offset, or -1 if it's full */
+static int retain(mu_Context *ctx, const void *src, int size) {
+    int offset = ctx->retained_list[ctx->frame & 1].idx;
+    if (offset + size > MU_RETAINEDLIST_SIZE) {
+        return -1;
+    }
+    memcpy(ctx->retained_list[ctx->frame & 1].items + offset, src, size);
+    ctx->retained_list[ctx->frame & 1].idx += size;
+    return offset;
+}
+
+/* keeps where a control in recorded content is, to tell whether the mouse is
+** over any of them once the content is replayed; a `hot` one makes the next
+** frame draw the content anew */
+static void retain_control(mu_Context *ctx, int hot, mu_Rect rect) {
+    mu_Retained *r = ctx->retaining ? &ctx->retaining->retained : &ctx->caching->retained;
+    r->hot |= hot;
+    if (r->controls >= 0) {
+        r->controls = retain(ctx, &rect, sizeof(rect)) < 0 ? -1 : r->controls + 1;
+    }
+}
+
 int mu_mouse_over(mu_Context *ctx, mu_Rect rect) {
+    /* recorded content is clipped against the panel only once it is replayed */
+    if (ctx->retaining && !rect_overlaps_vec2(ctx->retain_clip, ctx->mouse_pos)) {
+        return 0;
+    }
     return rect_overlaps_vec2(rect, ctx->mouse_pos) &&
            rect_overlaps_vec2(mu_get_clip_rect(ctx), ctx->mouse_pos) && in_hover_root(ctx);
 }
@@ -717,9 +1001,14 @@ void mu_update_control(mu_Context *ctx, mu_Id id, mu_Rect rect, int opt) {
             ctx->hover = 0;
         }
     }
+
+    if (ctx->retaining || ctx->caching) {
+        int hot = ctx->hover == id || ctx->focus == id;
+        retain_control(ctx, hot, intersect_rects(rect, mu_get_clip_rect(ctx)));
+    }
 }
 
-void mu_text(mu_Context *ctx, const char *text) {
+void mu_text_ex(mu_Context *ctx, const char *text, int opt) {
     const char *end, *p = text;
     int width = -1;
     mu_Font font = ctx->style->font;
@@ -735,26 +1024,38 @@ void mu_text(mu_Context *ctx, const char *text) {
             while (*p && *p != ' ' && *p != '\n') {
                 p++;
             }
-            w += ctx->text_width(font, word, p - word);
+            w += text_width(ctx, font, word, p - word);
             if (w > r.w && end != start) {
                 break;
             }
-            w += ctx->text_width(font, p, 1);
+            w += text_width(ctx, font, p, 1);
             end = p++;
         } while (*end && *end != '\n');
-        mu_draw_text(ctx, font, start, end - start, mu_vec2(r.x, r.y), color);
+        mu_draw_text_ex(ctx, font, start, end - start, mu_vec2(r.x, r.y), color, opt);
         p = end + 1;
     } while (*end);
     mu_layout_end_column(ctx);
 }
 
-void mu_label(mu_Context *ctx, const char *text) {
-    mu_draw_control_text(ctx, text, mu_layout_next(ctx), MU_COLOR_TEXT, 0);
+void mu_label_ex(mu_Context *ctx, const char *text, int opt) {
+    mu_draw_control_text(ctx, text, mu_layout_next(ctx), MU_COLOR_TEXT, opt);
+}
+
+void mu_label_l(mu_Context *ctx, mu_Label *label, int opt) {
+    draw_label(ctx, label, mu_layout_next(ctx), MU_COLOR_TEXT, opt);
 }
 
 int mu_button_ex(mu_Context *ctx, const char *label, int icon, int opt) {
+    mu_Label l;
+    if (label) {
+        l = mu_intern_label(label);
+    }
+    return mu_button_l(ctx, label ? &l : NULL, icon, opt);
+}
+
+int mu_button_l(mu_Context *ctx, mu_Label *label, int icon, int opt) {
     int res = 0;
-    mu_Id id = label ? mu_get_id(ctx, label, strlen(label)) : mu_get_id(ctx, &icon, sizeof(icon));
+    mu_Id id = label ? mu_get_label_id(ctx, label) : mu_get_id(ctx, &icon, sizeof(icon));
     mu_Rect r = mu_layout_next(ctx);
     mu_update_control(ctx, id, r, opt);
     /* handle click */
@@ -764,7 +1065,7 @@ int mu_button_ex(mu_Context *ctx, const char *label, int icon, int opt) {
     /* draw */
     mu_draw_control_frame(ctx, id, r, MU_COLOR_BUTTON, opt);
     if (label) {
-        mu_draw_control_text(ctx, label, r, MU_COLOR_TEXT, opt);
+        draw_label(ctx, label, r, MU_COLOR_TEXT, opt);
     }
     if (icon) {
         mu_draw_icon(ctx, icon, r, ctx->style->colors[MU_COLOR_TEXT]);
@@ -827,7 +1128,7 @@ int mu_textbox_raw(mu_Context *ctx, char *buf, int bufsz, mu_Id id, mu_Rect r, i
     if (ctx->focus == id) {
         mu_Color color = ctx->style->colors[MU_COLOR_TEXT];
         mu_Font font = ctx->style->font;
-        int textw = ctx->text_width(font, buf, -1);
+        int textw = text_width(ctx, font, buf, -1);
         int texth = ctx->text_height(font);
         int ofx = r.w - ctx->style->padding - textw - 1;
         int textx = r.x + mu_min(ofx, ctx->style->padding);
@@ -952,10 +1253,10 @@ int mu_number_ex(mu_Context *ctx, mu_Real *value, mu_Real step, const char *fmt,
     return res;
 }
 
-static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
+static int header(mu_Context *ctx, mu_Label *label, int istreenode, int opt) {
     mu_Rect r;
     int active, expanded;
-    mu_Id id = mu_get_id(ctx, label, strlen(label));
+    mu_Id id = mu_get_label_id(ctx, label);
     int idx = mu_pool_get(ctx, ctx->treenode_pool, MU_TREENODEPOOL_SIZE, id);
     int width = -1;
     mu_layout_row(ctx, 1, &width, 0);
@@ -998,16 +1299,26 @@ static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
     );
     r.x += r.h - ctx->style->padding;
     r.w -= r.h - ctx->style->padding;
-    mu_draw_control_text(ctx, label, r, MU_COLOR_TEXT, 0);
+    draw_label(ctx, label, r, MU_COLOR_TEXT, opt & MU_OPT_NOCOPY);
 
     return expanded ? MU_RES_ACTIVE : 0;
 }
 
 int mu_header_ex(mu_Context *ctx, const char *label, int opt) {
+    mu_Label l = mu_intern_label(label);
+    return header(ctx, &l, 0, opt);
+}
+
+int mu_header_l(mu_Context *ctx, mu_Label *label, int opt) {
     return header(ctx, label, 0, opt);
 }
 
 int mu_begin_treenode_ex(mu_Context *ctx, const char *label, int opt) {
+    mu_Label l = mu_intern_label(label);
+    return mu_begin_treenode_l(ctx, &l, opt);
+}
+
+int mu_begin_treenode_l(mu_Context *ctx, mu_Label *label, int opt) {
     int res = header(ctx, label, 1, opt);
     if (res & MU_RES_ACTIVE) {
         get_layout(ctx)->indent += ctx->style->indent;
@@ -1028,7 +1339,7 @@ void mu_end_treenode(mu_Context *ctx) {
                                                                                                    \
         if (maxscroll > 0 && b->h > 0) {                                                           \
             mu_Rect base, thumb;                                                                   \
-            mu_Id id = mu_get_id(ctx, "!scrollbar" #y, 11);                                        \
+            mu_Id id = mu_get_literal_id(ctx, "!scrollbar" #y);                                    \
                                                                                                    \
             /* get sizing / positioning */                                                         \
             base = *b;                                                                             \
@@ -1038,7 +1349,7 @@ void mu_end_treenode(mu_Context *ctx) {
             /* handle input */                                                                     \
             mu_update_control(ctx, id, base, 0);                                                   \
             if (ctx->focus == id && ctx->mouse_down == MU_MOUSE_LEFT) {                            \
-                cnt->scroll.y += ctx->mouse_delta.y * cs.y / base.h;                               \
+                cnt->scroll.y += (long long) ctx->mouse_delta.y * cs.y / base.h;                   \
             }                                                                                      \
             /* clamp scroll to limits */                                                           \
             cnt->scroll.y = mu_clamp(cnt->scroll.y, 0, maxscroll);                                 \
@@ -1047,7 +1358,7 @@ void mu_end_treenode(mu_Context *ctx) {
             ctx->draw_frame(ctx, base, MU_COLOR_SCROLLBASE);                                       \
             thumb = base;                                                                          \
             thumb.h = mu_max(ctx->style->thumb_size, base.h * b->h / cs.y);                        \
-            thumb.y += cnt->scroll.y * (base.h - thumb.h) / maxscroll;                             \
+            thumb.y += (long long) cnt->scroll.y * (base.h - thumb.h) / maxscroll;                 \
             ctx->draw_frame(ctx, thumb, MU_COLOR_SCROLLTHUMB);                                     \
                                                                                                    \
             /* set this as the scroll_target (will get scrolled on mousewheel) */                  \
@@ -1062,10 +1373,11 @@ void mu_end_treenode(mu_Context *ctx) {
     } while (0)
 
 static void scrollbars(mu_Context *ctx, mu_Container *cnt, mu_Rect *body) {
-    int sz = ctx->style->scrollbar_size;
+    int sz = ctx->style->scrollbar_size, scrollable;
     mu_Vec2 cs = cnt->content_size;
     cs.x += ctx->style->padding * 2;
     cs.y += ctx->style->padding * 2;
+    scrollable = cs.y > cnt->body.h || cs.x > cnt->body.w;
     mu_push_clip_rect(ctx, *body);
     /* resize body to make room for scrollbars */
     if (cs.y > cnt->body.h) {
@@ -1079,6 +1391,13 @@ static void scrollbars(mu_Context *ctx, mu_Container *cnt, mu_Rect *body) {
     scrollbar(ctx, cnt, body, cs, x, y, w, h);
     scrollbar(ctx, cnt, body, cs, y, x, h, w);
     mu_pop_clip_rect(ctx);
+    /* in recorded content, a panel that scrolls takes the mouse wheel like a
+    ** control, so the content isn't replayed while the mouse is over it; once
+    ** it scrolls, what was recorded is out of date */
+    if ((ctx->retaining || ctx->caching) && scrollable) {
+        int hot = ctx->scroll_target == cnt && (ctx->scroll_delta.x || ctx->scroll_delta.y);
+        retain_control(ctx, hot, intersect_rects(*body, mu_get_clip_rect(ctx)));
+    }
 }
 
 static void push_container_body(mu_Context *ctx, mu_Container *cnt, mu_Rect body, int opt) {
@@ -1090,9 +1409,20 @@ static void push_container_body(mu_Context *ctx, mu_Container *cnt, mu_Rect body
 }
 
 static void begin_root_container(mu_Context *ctx, mu_Container *cnt) {
+    /* its commands couldn't be moved along with recorded content */
+    expect(!ctx->retaining && !ctx->caching);
     push(ctx->container_stack, cnt);
     /* push container to roots list and push head command */
     push(ctx->root_list, cnt);
+#ifdef MU_FRAME_STATS
+    {
+        /* attribute everything until end_root_container() to this container */
+        mu_RootStats *stats = &ctx->frame_stats.roots[ctx->frame_stats.root_containers];
+        stats->container = cnt;
+        stats->parent = ctx->stats_root;
+        ctx->stats_root = ctx->frame_stats.root_containers++;
+    }
+#endif
     cnt->head = push_jump(ctx, NULL);
     /* set as hover root if the mouse is overlapping this container and it has a
     ** higher zindex than the current hover root */
@@ -1112,14 +1442,22 @@ static void end_root_container(mu_Context *ctx) {
     mu_Container *cnt = mu_get_current_container(ctx);
     cnt->tail = push_jump(ctx, NULL);
     cnt->head->jump.dst = ctx->command_list.items + ctx->command_list.idx;
+#ifdef MU_FRAME_STATS
+    ctx->stats_root = ctx->frame_stats.roots[ctx->stats_root].parent;
+#endif
     /* pop base clip rect and container */
     mu_pop_clip_rect(ctx);
     pop_container(ctx);
 }
 
 int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt) {
+    mu_Label l = mu_intern_label(title);
+    return mu_begin_window_l(ctx, &l, rect, opt);
+}
+
+int mu_begin_window_l(mu_Context *ctx, mu_Label *title, mu_Rect rect, int opt) {
     mu_Rect body;
-    mu_Id id = mu_get_id(ctx, title, strlen(title));
+    mu_Id id = mu_get_label_id(ctx, title);
     mu_Container *cnt = get_container(ctx, id, opt);
     if (!cnt || !cnt->open) {
         return 0;
@@ -1145,9 +1483,9 @@ int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt
 
         /* do title text */
         if (~opt & MU_OPT_NOTITLE) {
-            mu_Id id = mu_get_id(ctx, "!title", 6);
+            mu_Id id = mu_get_literal_id(ctx, "!title");
             mu_update_control(ctx, id, tr, opt);
-            mu_draw_control_text(ctx, title, tr, MU_COLOR_TITLETEXT, opt);
+            draw_label(ctx, title, tr, MU_COLOR_TITLETEXT, opt);
             if (id == ctx->focus && ctx->mouse_down == MU_MOUSE_LEFT) {
                 cnt->rect.x += ctx->mouse_delta.x;
                 cnt->rect.y += ctx->mouse_delta.y;
@@ -1158,7 +1496,7 @@ int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt
 
         /* do `close` button */
         if (~opt & MU_OPT_NOCLOSE) {
-            mu_Id id = mu_get_id(ctx, "!close", 6);
+            mu_Id id = mu_get_literal_id(ctx, "!close");
             mu_Rect r = mu_rect(tr.x + tr.w - tr.h, tr.y, tr.h, tr.h);
             tr.w -= r.w;
             mu_draw_icon(ctx, MU_ICON_CLOSE, r, ctx->style->colors[MU_COLOR_TITLETEXT]);
@@ -1174,7 +1512,7 @@ int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt
     /* do `resize` handle */
     if (~opt & MU_OPT_NORESIZE) {
         int sz = ctx->style->title_height;
-        mu_Id id = mu_get_id(ctx, "!resize", 7);
+        mu_Id id = mu_get_literal_id(ctx, "!resize");
         mu_Rect r = mu_rect(rect.x + rect.w - sz, rect.y + rect.h - sz, sz, sz);
         mu_update_control(ctx, id, r, opt);
         if (id == ctx->focus && ctx->mouse_down == MU_MOUSE_LEFT) {
@@ -1237,7 +1575,828 @@ void mu_begin_panel_ex(mu_Context *ctx, const char *name, int opt) {
     mu_push_clip_rect(ctx, cnt->body);
 }
 
+static void end_recording(mu_Context *ctx, mu_Container *cnt);
+
 void mu_end_panel(mu_Context *ctx) {
+    mu_Container *cnt = mu_get_current_container(ctx);
+    if (ctx->retaining == cnt) {
+        end_recording(ctx, cnt);
+    }
     mu_pop_clip_rect(ctx);
     pop_container(ctx);
 }
+
+/* emits recorded content moved by `delta`, culled and clipped against the
+** current clip rect just as it would have been if drawn there */
+static void replay_retained(mu_Context *ctx, const char *src, int size, mu_Vec2 delta) {
+    mu_Rect base = mu_get_clip_rect(ctx);
+    mu_Rect clip = base;
+    const char *end = src + size;
+    while (src < end) {
+        const mu_Command *cmd = (const mu_Command *) src;
+        mu_Command *out;
+        mu_Rect rect;
+        int clipped;
+        src += cmd->base.size;
+        switch (cmd->type) {
+        case MU_COMMAND_CLIP:
+            /* only set around text and icons, and reset right after */
+            clip = base;
+            if (memcmp(&cmd->clip.rect, &unclipped_rect, sizeof(mu_Rect))) {
+                clip = intersect_rects(move_rect(cmd->clip.rect, delta), base);
+            }
+            continue;
+        case MU_COMMAND_RECT:
+            rect = intersect_rects(move_rect(cmd->rect.rect, delta), base);
+            if (rect.w > 0 && rect.h > 0) {
+                out = mu_push_command(ctx, MU_COMMAND_RECT, sizeof(mu_RectCommand));
+                out->rect.rect = rect;
+                out->rect.color = cmd->rect.color;
+            }
+            continue;
+        case MU_COMMAND_TEXT:
+            rect.x = cmd->text.pos.x + delta.x;
+            rect.y = cmd->text.pos.y + delta.y;
+            rect.h = ctx->text_height(cmd->text.font);
+            /* only measure lines that are visible vertically */
+            if (rect.y > clip.y + clip.h || rect.y + rect.h < clip.y) {
+                continue;
+            }
+            rect.w = text_width(ctx, cmd->text.font, mu_text_str(&cmd->text), cmd->text.len);
+            break;
+        case MU_COMMAND_ICON:
+            rect = move_rect(cmd->icon.rect, delta);
+            break;
+        case MU_COMMAND_COLUMNS:
+            rect = move_rect(cmd->columns.rect, delta);
+            break;
+        case MU_COMMAND_FRAME:
+            mu_draw_frame(
+                ctx,
+                move_rect(cmd->frame.rect, delta),
+                cmd->frame.color,
+                cmd->frame.border,
+                cmd->frame.border_width
+            );
+            continue;
+        default:
+            continue;
+        }
+        /* text, icons and plots */
+        clipped = check_clip(rect, clip);
+        if (clipped == MU_CLIP_ALL) {
+            continue;
+        }
+        if (clipped == MU_CLIP_PART) {
+            mu_set_clip(ctx, clip);
+        }
+        out = mu_push_command(ctx, cmd->type, cmd->base.size);
+        memcpy(out, cmd, cmd->base.size);
+        if (cmd->type == MU_COMMAND_TEXT) {
+            out->text.pos = mu_vec2(rect.x, rect.y);
+        }
+        else if (cmd->type == MU_COMMAND_ICON) {
+            out->icon.rect = rect;
+        }
+        else {
+            out->columns.rect = rect;
+        }
+        if (clipped) {
+            mu_set_clip(ctx, unclipped_rect);
+        }
+    }
+}
+
+/* whether the mouse is over a control of the content replayed at `delta` */
+static int over_control(mu_Context *ctx, mu_Retained *r, mu_Vec2 delta) {
+    const char *rects = ctx->retained_list[r->frame & 1].items + r->rects;
+    int i;
+    if (r->controls < 0) {
+        return 1;
+    }
+    for (i = 0; i < r->controls; i++) {
+        mu_Rect rect;
+        memcpy(&rect, rects + i * sizeof(mu_Rect), sizeof(rect));
+        if (rect_overlaps_vec2(move_rect(rect, delta), ctx->mouse_pos)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* copies content recorded last frame over to this frame's retained list;
+** returns 0 if there's no room for it */
+static int carry_over(mu_Context *ctx, mu_Retained *r) {
+    const char *list = ctx->retained_list[r->frame & 1].items;
+    int offset = retain(ctx, list + r->offset, r->size);
+    int rects = retain(ctx, list + r->rects, mu_max(r->controls, 0) * sizeof(mu_Rect));
+    if (offset < 0 || rects < 0) {
+        return 0;
+    }
+    r->offset = offset;
+    r->rects = rects;
+    r->frame = ctx->frame;
+    return 1;
+}
+
+static int reuse_retained(mu_Context *ctx, mu_Container *cnt, unsigned version) {
+    mu_Retained *r = &cnt->retained;
+    mu_Vec2 delta = mu_vec2(r->scroll.x - cnt->scroll.x, r->scroll.y - cnt->scroll.y);
+    mu_Layout *layout = get_layout(ctx);
+    if (r->frame != ctx->frame - 1 || r->version != version ||
+        memcmp(&r->body, &cnt->body, sizeof(mu_Rect)) || r->hot || r->focus != ctx->focus ||
+        (r->controls && mu_mouse_over(ctx, cnt->body) && over_control(ctx, r, delta)) ||
+        !carry_over(ctx, r)) {
+        return 0;
+    }
+    replay_retained(ctx, ctx->retained_list[r->frame & 1].items + r->offset, r->size, delta);
+    layout->max.x = layout->body.x + r->content_size.x;
+    layout->max.y = layout->body.y + r->content_size.y;
+    return 1;
+}
+
+int mu_begin_scroll_panel(mu_Context *ctx, const char *name, unsigned version, int opt) {
+    mu_Container *cnt;
+    mu_Retained *r;
+    mu_begin_panel_ex(ctx, name, opt);
+    if (ctx->retaining || ctx->caching || !MU_RETAINEDLIST_SIZE) {
+        /* inside content being recorded, and recorded along with it, or
+        ** without retained lists */
+        return MU_RES_ACTIVE;
+    }
+    cnt = mu_get_current_container(ctx);
+    if (reuse_retained(ctx, cnt, version)) {
+        return 0;
+    }
+    /* record the content against an unbounded clip rect instead of the
+    ** panel's; it is culled and clipped as it is replayed in end_recording() */
+    r = &cnt->retained;
+    r->frame = -1;
+    r->version = version;
+    r->body = cnt->body;
+    r->scroll = cnt->scroll;
+    r->rects = ctx->retained_list[ctx->frame & 1].idx;
+    r->controls = r->hot = 0;
+    r->focus = ctx->focus;
+    ctx->retaining = cnt;
+    ctx->retain_clip = mu_get_clip_rect(ctx);
+    ctx->retain_start = ctx->command_list.idx;
+    ctx->clip_stack.items[ctx->clip_stack.idx - 1] = retained_rect;
+    return MU_RES_ACTIVE;
+}
+
+static void end_recording(mu_Context *ctx, mu_Container *cnt) {
+    mu_Retained *r = &cnt->retained;
+    mu_Layout *layout = get_layout(ctx);
+    char *src = ctx->command_list.items + ctx->retain_start;
+    int size = ctx->command_list.idx - ctx->retain_start;
+    /* only what is replayed below ends up in the frame */
+    stat_commands(ctx, src, size, -1);
+    ctx->retaining = NULL;
+    ctx->clip_stack.items[ctx->clip_stack.idx - 1] = ctx->retain_clip;
+    r->content_size.x = layout->max.x - layout->body.x;
+    r->content_size.y = layout->max.y - layout->body.y;
+    r->size = size;
+    r->offset = retain(ctx, src, size);
+    if (r->offset >= 0) {
+        r->frame = ctx->frame;
+        src = ctx->retained_list[r->frame & 1].items + r->offset;
+        ctx->command_list.idx = ctx->retain_start;
+        replay_retained(ctx, src, size, mu_vec2(0, 0));
+    }
+    else {
+        /* replay behind the recording and move the result over it */
+        replay_retained(ctx, src, size, mu_vec2(0, 0));
+        memmove(src, src + size, ctx->command_list.idx - ctx->retain_start - size);
+        ctx->command_list.idx -= size;
+    }
+}
+
+/*============================================================================
+** cached regions
+**============================================================================*/
+
+static int reuse_region(mu_Context *ctx, mu_CachedRegion *region, unsigned version) {
+    mu_Retained *r = &region->retained;
+    mu_Rect clip = mu_get_clip_rect(ctx);
+    mu_Layout *layout = get_layout(ctx);
+    char *dst = ctx->command_list.items + ctx->command_list.idx;
+    if (r->frame != ctx->frame - 1 || r->version != version || r->hot ||
+        r->focus != ctx->focus || memcmp(&r->body, &clip, sizeof(mu_Rect)) ||
+        memcmp(&region->layout[0], layout, sizeof(mu_Layout))) {
+        return 0;
+    }
+    /* input reaching the region */
+    if (mu_mouse_over(ctx, region->bounds) &&
+        (ctx->mouse_pressed || ctx->scroll_delta.x || ctx->scroll_delta.y ||
+         over_control(ctx, r, mu_vec2(0, 0)))) {
+        return 0;
+    }
+    if (!carry_over(ctx, r)) {
+        return 0;
+    }
+    /* the commands don't move, so they are copied as they are */
+    expect(ctx->command_list.idx + r->size < MU_COMMANDLIST_SIZE);
+    memcpy(dst, ctx->retained_list[r->frame & 1].items + r->offset, r->size);
+    ctx->command_list.idx += r->size;
+    stat_commands(ctx, dst, r->size, 1);
+    *layout = region->layout[1];
+    return 1;
+}
+
+int mu_begin_cached(mu_Context *ctx, mu_Id id, unsigned version) {
+    mu_CachedRegion *region;
+    mu_Retained *r;
+    int idx;
+    ctx->cached_depth++;
+    if (ctx->retaining || ctx->caching || !MU_RETAINEDLIST_SIZE) {
+        /* inside content being recorded, and recorded along with it, or
+        ** without retained lists */
+        return MU_RES_ACTIVE;
+    }
+    idx = mu_pool_get(ctx, ctx->cached_pool, MU_CACHEPOOL_SIZE, id);
+    if (idx >= 0) {
+        mu_pool_update(ctx, ctx->cached_pool, idx);
+    }
+    else {
+        idx = mu_pool_init(ctx, ctx->cached_pool, MU_CACHEPOOL_SIZE, id);
+        ctx->cached[idx].retained.frame = -1;
+    }
+    region = &ctx->cached[idx];
+    if (reuse_region(ctx, region, version)) {
+        return 0;
+    }
+    /* record it as it is built */
+    r = &region->retained;
+    r->frame = -1;
+    r->version = version;
+    r->body = mu_get_clip_rect(ctx);
+    r->rects = ctx->retained_list[ctx->frame & 1].idx;
+    r->controls = r->hot = 0;
+    r->focus = ctx->focus;
+    region->bounds = mu_rect(0, 0, 0, 0);
+    region->layout[0] = *get_layout(ctx);
+    ctx->caching = region;
+    ctx->caching_depth = ctx->cached_depth;
+    ctx->retain_start = ctx->command_list.idx;
+    return MU_RES_ACTIVE;
+}
+
+void mu_end_cached(mu_Context *ctx) {
+    mu_CachedRegion *region = ctx->caching;
+    expect(ctx->cached_depth > 0);
+    if (region && ctx->caching_depth == ctx->cached_depth) {
+        mu_Retained *r = &region->retained;
+        r->size = ctx->command_list.idx - ctx->retain_start;
+        r->offset = retain(ctx, ctx->command_list.items + ctx->retain_start, r->size);
+        r->frame = r->offset < 0 ? -1 : ctx->frame;
+        region->layout[1] = *get_layout(ctx);
+        ctx->caching = NULL;
+    }
+    ctx->cached_depth--;
+}
+
+/*============================================================================
+** tables
+**============================================================================*/
+
+/* the measured heights are kept as a Fenwick tree of their differences from
+** the default pitch, so rows are found and their offsets summed in O(log n) */
+static int table_offset(const mu_Table *table, int pitch, int n) {
+    int res = n * pitch;
+    if (!table->row_height) {
+        for (; n > 0; n -= n & -n) {
+            res += table->heights[n - 1];
+        }
+    }
+    return res;
+}
+
+/* index of the row at `y`, counted from the top of the first row */
+static int table_row_at(const mu_Table *table, int pitch, int y) {
+    int n = 0, step = 1;
+    if (table->row_height) {
+        n = y / pitch;
+    }
+    else {
+        while (step * 2 <= table->rows) {
+            step *= 2;
+        }
+        for (; step > 0; step /= 2) {
+            int h = step * pitch;
+            if (n + step <= table->rows && h + table->heights[n + step - 1] <= y) {
+                y -= h + table->heights[n + step - 1];
+                n += step;
+            }
+        }
+    }
+    return mu_clamp(n, 0, table->rows - 1);
+}
+
+static void table_measure(mu_Table *table, int pitch, int row, int measured) {
+    int delta = measured - (table_offset(table, pitch, row + 1) - table_offset(table, pitch, row));
+    for (row++; delta && row <= table->rows; row += row & -row) {
+        table->heights[row - 1] += delta;
+    }
+}
+
+void mu_begin_table(mu_Context *ctx, const char *name, mu_Table *table, int opt) {
+    mu_Container *cnt;
+    mu_Layout *layout;
+    mu_Rect rect;
+    int height = ctx->style->size.y + ctx->style->padding * 2;
+    int pitch = (table->row_height ? table->row_height : height) + ctx->style->spacing;
+    int top = 0, i, last;
+    mu_begin_panel_ex(ctx, name, opt);
+    cnt = mu_get_current_container(ctx);
+    layout = get_layout(ctx);
+    if (!table->row_height && table->measured_rows != table->rows) {
+        memset(table->heights, 0, table->rows * sizeof(int));
+        table->measured_rows = table->rows;
+    }
+    /* header row, pinned to the top of the body */
+    rect = mu_rect(cnt->body.x, cnt->body.y, cnt->body.w, 0);
+    if (table->titles) {
+        layout->next_row = cnt->scroll.y;
+        mu_layout_row(ctx, table->columns, table->widths, height);
+        for (i = 0; i < table->columns; i++) {
+            rect = mu_layout_next(ctx);
+            ctx->draw_frame(ctx, rect, MU_COLOR_TITLEBG);
+            mu_draw_control_text(ctx, table->titles[i], rect, MU_COLOR_TITLETEXT, 0);
+        }
+        top = height + ctx->style->spacing;
+    }
+    rect.y += rect.h;
+    rect.h = cnt->body.y + cnt->body.h - rect.y;
+    mu_push_clip_rect(ctx, mu_rect(cnt->body.x, rect.y, cnt->body.w, rect.h));
+    /* lay out the rows in view only, each where the ones before it end */
+    if (table->rows > 0) {
+        i = table_row_at(table, pitch, cnt->scroll.y);
+        last = table_row_at(table, pitch, cnt->scroll.y + cnt->body.h);
+        layout->next_row = top + table_offset(table, pitch, i);
+        for (; i <= last; i++) {
+            int y = layout->next_row;
+            mu_push_id(ctx, &i, sizeof(i));
+            mu_layout_row(ctx, table->columns, table->widths, table->row_height);
+            table->row(ctx, i, table->udata);
+            mu_pop_id(ctx);
+            if (!table->row_height) {
+                table_measure(table, pitch, i, layout->next_row - y);
+            }
+        }
+    }
+    /* the content size covers every row */
+    i = top + table_offset(table, pitch, table->rows) - ctx->style->spacing;
+    layout->max.y = mu_max(layout->max.y, layout->body.y + i);
+}
+
+void mu_end_table(mu_Context *ctx) {
+    mu_pop_clip_rect(ctx);
+    mu_end_panel(ctx);
+}
+
+/*============================================================================
+** plots
+**============================================================================*/
+
+#define PLOT_BLOCK 8
+
+/* the smallest and largest of `n` > 0 samples, eight at a time */
+static void minmax(const float *p, int n, float *lo, float *hi) {
+    float mn = p[0], mx = p[0];
+    int i = 0;
+#ifdef __SSE2__
+    if (n >= 8) {
+        __m128 mn0 = _mm_loadu_ps(p), mx0 = mn0;
+        __m128 mn1 = _mm_loadu_ps(p + 4), mx1 = mn1;
+        for (i = 8; i + 8 <= n; i += 8) {
+            __m128 a = _mm_loadu_ps(p + i);
+            __m128 b = _mm_loadu_ps(p + i + 4);
+            mn0 = _mm_min_ps(mn0, a);
+            mx0 = _mm_max_ps(mx0, a);
+            mn1 = _mm_min_ps(mn1, b);
+            mx1 = _mm_max_ps(mx1, b);
+        }
+        mn0 = _mm_min_ps(mn0, mn1);
+        mx0 = _mm_max_ps(mx0, mx1);
+        mn0 = _mm_min_ps(mn0, _mm_shuffle_ps(mn0, mn0, _MM_SHUFFLE(1, 0, 3, 2)));
+        mx0 = _mm_max_ps(mx0, _mm_shuffle_ps(mx0, mx0, _MM_SHUFFLE(1, 0, 3, 2)));
+        mn0 = _mm_min_ps(mn0, _mm_shuffle_ps(mn0, mn0, _MM_SHUFFLE(2, 3, 0, 1)));
+        mx0 = _mm_max_ps(mx0, _mm_shuffle_ps(mx0, mx0, _MM_SHUFFLE(2, 3, 0, 1)));
+        mn = _mm_cvtss_f32(mn0);
+        mx = _mm_cvtss_f32(mx0);
+    }
+#endif
+    for (; i < n; i++) {
+        mn = mu_min(mn, p[i]);
+        mx = mu_max(mx, p[i]);
+    }
+    *lo = mn;
+    *hi = mx;
+}
+
+/* level `k` holds the min/max pairs of blocks of PLOT_BLOCK << k samples,
+** after the levels below it */
+static float *plot_level(const mu_Plot *plot, int k) {
+    return plot->pyramid + (plot->capacity / 2 - (plot->capacity / 2 >> k));
+}
+
+/* fills in the pairs of the blocks completed since `count` samples */
+static void plot_update(mu_Plot *plot, int count) {
+    int k, i;
+    for (k = 0; PLOT_BLOCK << k <= plot->capacity; k++) {
+        float *level = plot_level(plot, k);
+        float *below = k ? plot_level(plot, k - 1) : NULL;
+        int size = PLOT_BLOCK << k;
+        for (i = count / size; i < plot->count / size; i++) {
+            if (below) {
+                level[i * 2] = mu_min(below[i * 4], below[i * 4 + 2]);
+                level[i * 2 + 1] = mu_max(below[i * 4 + 1], below[i * 4 + 3]);
+            }
+            else {
+                minmax(plot->samples + i * size, size, &level[i * 2], &level[i * 2 + 1]);
+            }
+        }
+    }
+}
+
+/* min/max of the samples from `lo` up to `hi`: the whole blocks in between
+** are taken from the pyramid, climbing a level whenever what is left of them
+** is aligned to its blocks, and the ends from the samples */
+static void plot_range(const mu_Plot *plot, int lo, int hi, float *mn, float *mx) {
+    int first = (lo + PLOT_BLOCK - 1) / PLOT_BLOCK, last = hi / PLOT_BLOCK, k;
+    float l, h, a, b;
+    if (!plot->pyramid || hi - lo < PLOT_BLOCK * 2) {
+        minmax(plot->samples + lo, hi - lo, mn, mx);
+        return;
+    }
+    /* with the first block's first sample, so the head is never empty */
+    minmax(plot->samples + lo, first * PLOT_BLOCK - lo + 1, &l, &h);
+    if (last * PLOT_BLOCK < hi) {
+        minmax(plot->samples + last * PLOT_BLOCK, hi - last * PLOT_BLOCK, &a, &b);
+        l = mu_min(l, a);
+        h = mu_max(h, b);
+    }
+    for (k = 0; first < last; k++, first /= 2, last /= 2) {
+        const float *level = plot_level(plot, k);
+        if (first & 1) {
+            l = mu_min(l, level[first * 2]);
+            h = mu_max(h, level[first * 2 + 1]);
+            first++;
+        }
+        if (last & 1) {
+            last--;
+            l = mu_min(l, level[last * 2]);
+            h = mu_max(h, level[last * 2 + 1]);
+        }
+    }
+    *mn = l;
+    *mx = h;
+}
+
+/* row of `value` in a plot `h` rows high, 0 being the top */
+static int plot_row(float value, float high, float scale, int h) {
+    float y = (high - value) * scale + 0.5f;
+    if (!(y >= 0)) {
+        return 0;
+    }
+    return y < h - 1 ? (int) y : h - 1;
+}
+
+static void draw_plot(mu_Context *ctx, const mu_Plot *plot, int start, float low, float high) {
+    mu_Rect rect = mu_layout_next(ctx);
+    int count = plot->count - start;
+    float scale, mn, mx;
+    mu_Command *cmd;
+    int clipped, i;
+    ctx->draw_frame(ctx, rect, MU_COLOR_BASE);
+    rect = expand_rect(rect, -1);
+    rect.h = mu_min(rect.h, 0xffff);
+    if (rect.w <= 0 || rect.h <= 0 || count <= 0) {
+        return;
+    }
+    clipped = begin_clip(ctx, rect);
+    if (clipped == MU_CLIP_ALL) {
+        return;
+    }
+    cmd = mu_push_command(
+        ctx,
+        MU_COMMAND_COLUMNS,
+        sizeof(mu_ColumnsCommand) + (rect.w - 1) * 2 * sizeof(unsigned short)
+    );
+    cmd->columns.rect = rect;
+    cmd->columns.color = ctx->style->colors[MU_COLOR_TEXT];
+    scale = high > low ? (rect.h - 1) / (high - low) : 0;
+    for (i = 0; i < rect.w; i++) {
+        /* the column's samples, and the next one to join it to its neighbour */
+        int lo = start + (int) ((long long) count * i / rect.w);
+        int hi = start + (int) ((long long) count * (i + 1) / rect.w);
+        hi = mu_min(mu_max(hi, lo + 1) + 1, plot->count);
+        plot_range(plot, lo, hi, &mn, &mx);
+        cmd->columns.spans[i * 2] = plot_row(mx, high, scale, rect.h);
+        cmd->columns.spans[i * 2 + 1] = plot_row(mn, high, scale, rect.h) + 1;
+    }
+    /* reset clipping if it was set */
+    if (clipped) {
+        mu_set_clip(ctx, unclipped_rect);
+    }
+}
+
+void mu_plot(mu_Context *ctx, const float *samples, int count, float low, float high) {
+    mu_Plot plot = {(float *) samples, NULL, count, count};
+    draw_plot(ctx, &plot, 0, low, high);
+}
+
+void mu_plot_init(mu_Plot *plot, float *samples, float *pyramid, int capacity) {
+    expect(capacity >= PLOT_BLOCK && (capacity & (capacity - 1)) == 0);
+    plot->samples = samples;
+    plot->pyramid = pyramid;
+    plot->capacity = capacity;
+    plot->count = 0;
+}
+
+void mu_plot_append(mu_Plot *plot, const float *values, int count) {
+    int half = plot->capacity / 2;
+    while (count > 0) {
+        int k, n;
+        if (plot->count == plot->capacity) {
+            /* drop the older half; the blocks of the newer one move along */
+            memmove(plot->samples, plot->samples + half, half * sizeof(float));
+            for (k = 0; PLOT_BLOCK << k <= half; k++) {
+                float *level = plot_level(plot, k);
+                n = half / (PLOT_BLOCK << k) * 2;
+                memmove(level, level + n, n * sizeof(float));
+            }
+            plot->count = half;
+        }
+        n = mu_min(count, plot->capacity - plot->count);
+        memcpy(plot->samples + plot->count, values, n * sizeof(float));
+        plot->count += n;
+        plot_update(plot, plot->count - n);
+        values += n;
+        count -= n;
+    }
+}
+
+void mu_plot_series(mu_Context *ctx, const mu_Plot *plot, int window, float low, float high) {
+    draw_plot(ctx, plot, mu_max(plot->count - window, 0), low, high);
+}
+
+/*============================================================================
+** command list optimizer
+**============================================================================*/
+
+#define OPTIMIZE_LOOKBACK 8 /* a power of two */
+
+static int contains_rect(mu_Rect a, mu_Rect b) {
+    return b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+}
+
+/* extends `a` to cover `b` too if together they make up a rect, overlapping
+** only if `overlap` is set */
+static int merge_rect(mu_Rect *a, mu_Rect b, int overlap) {
+    mu_Rect u;
+    int span, extent;
+    if (overlap && contains_rect(*a, b)) {
+        return 1;
+    }
+    /* the cheap test first, as most neighbouring rects don't line up */
+    if (a->y == b.y && a->h == b.h) {
+        u = union_rects(*a, b);
+        span = a->w + b.w;
+        extent = u.w;
+    }
+    else if (a->x == b.x && a->w == b.w) {
+        u = union_rects(*a, b);
+        span = a->h + b.h;
+        extent = u.h;
+    }
+    else {
+        return 0;
+    }
+    if (overlap ? extent > span : extent != span) {
+        return 0;
+    }
+    *a = u;
+    return 1;
+}
+
+/* turns `cmd` into a jump over itself */
+static int drop_command(mu_Command *cmd) {
+    cmd->type = MU_COMMAND_JUMP;
+    cmd->jump.dst = (char *) cmd + cmd->base.size;
+    return 1;
+}
+
+/* walks the commands in the order they are drawn, tracking the clip rect a
+** renderer would have, which is unclipped at the start of the frame */
+static int optimize_commands(mu_Context *ctx) {
+    mu_Command *rects[OPTIMIZE_LOOKBACK]; /* ring of recent rects, to find covered ones */
+    mu_Command *pending = NULL; /* clip rect set, but not drawn with yet */
+    mu_Rect clip = unclipped_rect;
+    int dropped = 0, i, j, n;
+    for (i = 0; i < ctx->root_list.idx; i++) {
+        mu_Container *cnt = ctx->root_list.items[i];
+        mu_Command *cmd = (mu_Command *) ((char *) cnt->head + sizeof(mu_JumpCommand));
+        mu_Command *prev = NULL; /* rect drawn right before this command */
+        mu_Command *next;
+        n = 0;
+        for (; cmd != cnt->tail; cmd = next) {
+            mu_Rect cover = mu_rect(0, 0, 0, 0);
+            next = (mu_Command *) ((char *) cmd + cmd->base.size);
+            if (cmd->type == MU_COMMAND_JUMP) {
+                /* over a nested root container, drawn after this one */
+                next = cmd->jump.dst;
+                continue;
+            }
+            if (cmd->type == MU_COMMAND_CLIP) {
+                if (pending) {
+                    dropped += drop_command(pending);
+                }
+                pending = cmd;
+                if (!memcmp(&cmd->clip.rect, &clip, sizeof(mu_Rect))) {
+                    dropped += drop_command(cmd);
+                    pending = NULL;
+                }
+                continue;
+            }
+            if (pending) {
+                clip = pending->clip.rect;
+                pending = NULL;
+                prev = NULL;
+            }
+            if (cmd->type == MU_COMMAND_RECT) {
+                int opaque = cmd->rect.color.a == 255;
+                if (cmd->rect.color.a == 0) {
+                    dropped += drop_command(cmd);
+                    continue;
+                }
+                if (prev && !memcmp(&prev->rect.color, &cmd->rect.color, sizeof(mu_Color)) &&
+                    merge_rect(&prev->rect.rect, cmd->rect.rect, opaque)) {
+                    dropped += drop_command(cmd);
+                    cmd = prev;
+                }
+                else {
+                    rects[n++ & (OPTIMIZE_LOOKBACK - 1)] = prev = cmd;
+                }
+                if (opaque) {
+                    cover = intersect_rects(cmd->rect.rect, clip);
+                }
+            }
+            else {
+                prev = NULL;
+                if (cmd->type == MU_COMMAND_FRAME && cmd->frame.color.a == 255 &&
+                    cmd->frame.border.a == 255) {
+                    cover = intersect_rects(cmd->frame.rect, clip);
+                }
+            }
+            /* earlier rects hidden under this one; most rects are one pixel
+            ** border lines, which are not worth the lookback */
+            if (cover.w <= 1 || cover.h <= 1) {
+                continue;
+            }
+            for (j = 0; j < mu_min(n, OPTIMIZE_LOOKBACK); j++) {
+                if (rects[j] && rects[j] != cmd && contains_rect(cover, rects[j]->rect.rect)) {
+                    dropped += drop_command(rects[j]);
+                    rects[j] = NULL;
+                }
+            }
+        }
+    }
+    return dropped;
+}
+
+/*============================================================================
+** occlusion culling
+**============================================================================*/
+
+/* the area `cmd` draws to; icons are assumed to fit their rect */
+static int command_rect(mu_Context *ctx, mu_Command *cmd, mu_Rect *rect) {
+    switch (cmd->type) {
+    case MU_COMMAND_RECT:
+        *rect = cmd->rect.rect;
+        return 1;
+    case MU_COMMAND_ICON:
+        *rect = cmd->icon.rect;
+        return 1;
+    case MU_COMMAND_COLUMNS:
+        *rect = cmd->columns.rect;
+        return 1;
+    case MU_COMMAND_FRAME:
+        *rect = cmd->frame.rect;
+        return 1;
+    case MU_COMMAND_TEXT:
+        rect->x = cmd->text.pos.x;
+        rect->y = cmd->text.pos.y;
+        rect->w = text_width(ctx, cmd->text.font, mu_text_str(&cmd->text), cmd->text.len);
+        rect->h = ctx->text_height(cmd->text.font);
+        return 1;
+    }
+    return 0;
+}
+
+/* cuts off the side of `r` that `cover` hides across its whole height or width */
+static void trim_rect(mu_Rect *r, mu_Rect cover) {
+    if (cover.y <= r->y && cover.y + cover.h >= r->y + r->h) {
+        if (cover.x <= r->x && cover.x + cover.w > r->x) {
+            r->w -= cover.x + cover.w - r->x;
+            r->x = cover.x + cover.w;
+        }
+        else if (cover.x < r->x + r->w && cover.x + cover.w >= r->x + r->w) {
+            r->w = cover.x - r->x;
+        }
+    }
+    else if (cover.x <= r->x && cover.x + cover.w >= r->x + r->w) {
+        if (cover.y <= r->y && cover.y + cover.h > r->y) {
+            r->h -= cover.y + cover.h - r->y;
+            r->y = cover.y + cover.h;
+        }
+        else if (cover.y < r->y + r->h && cover.y + cover.h >= r->y + r->h) {
+            r->h = cover.y - r->y;
+        }
+    }
+}
+
+/* walks the roots from the front, collecting the rect each one covers with
+** the opaque rect or frame it draws first, and drops the commands of the
+** roots below that are hidden under those. A root whose commands are all
+** hidden is taken out of the root list, so it is skipped with one jump;
+** like the library's own drawing, each root starts and ends unclipped */
+static int cull_occluded(mu_Context *ctx) {
+    mu_Rect covers[MU_ROOTLIST_SIZE]; /* filled from the end, so the nearest comes first */
+    int dropped = 0, i, k, n = 0;
+    for (i = ctx->root_list.idx - 1; i >= 0; i--) {
+        mu_Container *cnt = ctx->root_list.items[i];
+        mu_Command *cmd = (mu_Command *) ((char *) cnt->head + sizeof(mu_JumpCommand));
+        mu_Command *next;
+        mu_Rect *above = covers + MU_ROOTLIST_SIZE - n;
+        mu_Rect clip = unclipped_rect, cover = mu_rect(0, 0, 0, 0), r;
+        int first = 1, visible = 0;
+        for (; cmd != cnt->tail; cmd = next) {
+            next = (mu_Command *) ((char *) cmd + cmd->base.size);
+            if (cmd->type == MU_COMMAND_JUMP) {
+                next = cmd->jump.dst;
+                continue;
+            }
+            if (cmd->type == MU_COMMAND_CLIP) {
+                clip = cmd->clip.rect;
+                continue;
+            }
+            if (first) {
+                first = 0;
+                if ((cmd->type == MU_COMMAND_RECT && cmd->rect.color.a == 255) ||
+                    (cmd->type == MU_COMMAND_FRAME && cmd->frame.color.a == 255 &&
+                     cmd->frame.border.a == 255)) {
+                    command_rect(ctx, cmd, &cover);
+                    cover = intersect_rects(cover, clip);
+                }
+                if (n == 0) {
+                    /* nothing above to be hidden under */
+                    visible = 1;
+                    break;
+                }
+            }
+            if (cmd->type == MU_COMMAND_TEXT) {
+                /* only measure lines that start under a cover */
+                r = mu_rect(cmd->text.pos.x, cmd->text.pos.y, 1, ctx->text_height(cmd->text.font));
+                r = intersect_rects(r, clip);
+                for (k = 0; k < n && !contains_rect(above[k], r); k++) {}
+                if (k == n) {
+                    visible = 1;
+                    continue;
+                }
+            }
+            if (!command_rect(ctx, cmd, &r)) {
+                visible = 1;
+                continue;
+            }
+            r = intersect_rects(r, clip);
+            /* hidden under one cover, or under several that each trim a side */
+            for (k = 0; k < n && r.w > 0 && r.h > 0 && !contains_rect(above[k], r); k++) {
+                trim_rect(&r, above[k]);
+            }
+            if (k < n || r.w <= 0 || r.h <= 0) {
+                dropped += drop_command(cmd);
+                continue;
+            }
+            if (cmd->type == MU_COMMAND_RECT && memcmp(&r, &cmd->rect.rect, sizeof(mu_Rect))) {
+                /* clipped or trimmed, which doesn't change what is drawn */
+                cmd->rect.rect = r;
+            }
+            visible = 1;
+        }
+        if (!visible && !memcmp(&clip, &unclipped_rect, sizeof(mu_Rect))) {
+            ctx->root_list.idx--;
+            memmove(
+                ctx->root_list.items + i,
+                ctx->root_list.items + i + 1,
+                (ctx->root_list.idx - i) * sizeof(mu_Container *)
+            );
+            ctx->culled_roots++;
+        }
+        if (cover.w > 0 && cover.h > 0) {
+            covers[MU_ROOTLIST_SIZE - ++n] = cover;
+        }
+    }
+    return dropped;
+}
@@ -1,25 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "renderer.h"
-#include "atlas.inl"
+#include "batch.h"
+#include "gl3_renderer.h"
+#include "soft_renderer.h"
+#include "trace.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
-#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define BUFFER_SIZE 16384
 
-static GLfloat tex_buf[BUFFER_SIZE * 8];
-static GLfloat vert_buf[BUFFER_SIZE * 8];
-static GLubyte color_buf[BUFFER_SIZE * 16];
+/*============================================================================
+** window: OpenGL 1.x client arrays
+**============================================================================*/
+
+// The index pattern never changes, so every instance draws from one copy
 static GLuint index_buf[BUFFER_SIZE * 6];
+static pthread_once_t index_buf_once = PTHREAD_ONCE_INIT;
+
+typedef struct
+{
+    renderer_t base;
+    SDL_Window *window;
+    SDL_GLContext context;
+    batch_t batch;
+    batch_cache_t *cache;
+    batch_workers_t *workers;
+    glyph_atlas_t *glyphs;
+
+    /* clip with glScissor, flushing on every clip change, instead of clipping
+    ** quads on the CPU; kept for primitives that can't be clipped as rects */
+    int scissor_clip;
+} gl_renderer_t;
+
+static const renderer_backend_t gl_backend;
+
+static void fill_index_buf(void) {
+    batch_fill_indices(index_buf, BUFFER_SIZE);
+}
+
+static void flush_batch(batch_t *b) {
+    if (b->quads == 0) {
+        return;
+    }
+    gl_renderer_t *r = (gl_renderer_t *) ((char *) b - offsetof(gl_renderer_t, batch));
+    int width = r->base.width, height = r->base.height;
 
-static int width = 800;
-static int height = 600;
-static int buf_idx;
+    trace_begin("flush");
+    mu_Rect dirty;
+    if (ga_take_dirty(r->glyphs, &dirty)) {
+        /* whole texture rows are contiguous in memory, so no unpack stride */
+        glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            0,
+            dirty.y,
+            GA_TEXTURE_WIDTH,
+            dirty.h,
+            GL_ALPHA,
+            GL_UNSIGNED_BYTE,
+            ga_texture(r->glyphs) + dirty.y * GA_TEXTURE_WIDTH
+        );
+    }
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0f, width, height, 0.0f, -1.0f, +1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
 
-static SDL_Window *window;
+    glTexCoordPointer(2, GL_FLOAT, sizeof(batch_vertex_t), &b->vertices[0].u);
+    glVertexPointer(2, GL_FLOAT, sizeof(batch_vertex_t), &b->vertices[0].x);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(batch_vertex_t), &b->vertices[0].color);
+    glDrawElements(GL_TRIANGLES, b->quads * 6, GL_UNSIGNED_INT, index_buf);
 
-void r_init(void) {
-    /* init SDL window */
-    window = SDL_CreateWindow(
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+
+    b->quads = 0;
+    trace_end("flush");
+}
+
+static void gl_destroy(renderer_t *base) {
+    gl_renderer_t *r = (gl_renderer_t *) base;
+    batch_workers_destroy(r->workers);
+    batch_cache_destroy(r->cache);
+    ga_destroy(r->glyphs);
+    free(r->batch.vertices);
+    if (r->context) {
+        SDL_GL_DeleteContext(r->context);
+    }
+    if (r->window) {
+        SDL_DestroyWindow(r->window);
+    }
+    free(r);
+}
+
+static renderer_t *gl_create(int width, int height) {
+    gl_renderer_t *r = calloc(1, sizeof(gl_renderer_t));
+    if (!r) {
+        return NULL;
+    }
+    r->base = (renderer_t) {&gl_backend, width, height};
+
+    /* init SDL window; ask for a compatibility context explicitly, since
+    ** a gl3 instance may have changed the attributes */
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, 0);
+    r->window = SDL_CreateWindow(
         NULL,
         SDL_WINDOWPOS_UNDEFINED,
         SDL_WINDOWPOS_UNDEFINED,
@@ -27,7 +125,16 @@ void r_init(void) {
         height,
         SDL_WINDOW_OPENGL
     );
-    SDL_GL_CreateContext(window);
+    r->context = r->window ? SDL_GL_CreateContext(r->window) : NULL;
+    batch_vertex_t *vertices = malloc(BUFFER_SIZE * 4 * sizeof(batch_vertex_t));
+    r->cache = batch_cache_create();
+    r->glyphs = ga_create(GA_MAX_PAGES);
+    if (!r->context || !vertices || !r->cache || !r->glyphs) {
+        fprintf(stderr, "Renderer: cannot create a GL window: %s\n", SDL_GetError());
+        free(vertices);
+        gl_destroy(&r->base);
+        return NULL;
+    }
 
     /* init gl */
     glEnable(GL_BLEND);
@@ -35,12 +142,18 @@ void r_init(void) {
     glDisable(GL_CULL_FACE);
     glDisable(GL_DEPTH_TEST);
     glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, width, height);
     glEnable(GL_TEXTURE_2D);
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
 
-    /* init texture */
+    /* init batch */
+    batch_init(&r->batch, vertices, BUFFER_SIZE, flush_batch);
+    r->batch.glyphs = r->glyphs;
+    pthread_once(&index_buf_once, fill_index_buf);
+
+    /* init texture; glyphs beyond ASCII are uploaded as they get packed */
     GLuint id;
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_2D, id);
@@ -48,149 +161,396 @@ void r_init(void) {
         GL_TEXTURE_2D,
         0,
         GL_ALPHA,
-        ATLAS_WIDTH,
-        ATLAS_HEIGHT,
+        GA_TEXTURE_WIDTH,
+        GA_TEXTURE_HEIGHT,
         0,
         GL_ALPHA,
         GL_UNSIGNED_BYTE,
-        atlas_texture
+        ga_texture(r->glyphs)
     );
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    assert(glGetError() == 0);
+    if (glGetError() != GL_NO_ERROR) {
+        fprintf(stderr, "Renderer: GL setup failed\n");
+        gl_destroy(&r->base);
+        return NULL;
+    }
+    return &r->base;
+}
+
+/* each instance has its own context; bind it before issuing GL calls */
+static gl_renderer_t *gl_bind(renderer_t *base) {
+    gl_renderer_t *r = (gl_renderer_t *) base;
+    SDL_GL_MakeCurrent(r->window, r->context);
+    return r;
 }
 
-static void flush(void) {
-    if (buf_idx == 0) {
+static void gl_set_clip_rect(gl_renderer_t *r, mu_Rect rect) {
+    if (!r->scissor_clip) {
+        batch_set_clip(&r->batch, rect);
         return;
     }
+    flush_batch(&r->batch);
+    glScissor(rect.x, r->base.height - (rect.y + rect.h), rect.w, rect.h);
+}
 
-    glViewport(0, 0, width, height);
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0.0f, width, height, 0.0f, -1.0f, +1.0f);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+static void gl_render(renderer_t *base, mu_Context *ctx) {
+    gl_renderer_t *r = gl_bind(base);
+    ga_begin_frame(r->glyphs);
+    if (!r->scissor_clip && r->workers) {
+        batch_set_clip(&r->batch, mu_rect(0, 0, 0x1000000, 0x1000000));
+        batch_render_parallel(&r->batch, r->workers, ctx);
+        return;
+    }
+    if (!r->scissor_clip) {
+        /* windows whose commands didn't change reuse last frame's vertices */
+        batch_set_clip(&r->batch, mu_rect(0, 0, 0x1000000, 0x1000000));
+        batch_render(&r->batch, r->cache, ctx);
+        return;
+    }
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        switch (cmd->type) {
+        case MU_COMMAND_TEXT:
+            batch_draw_text(
+                &r->batch, mu_text_str(&cmd->text), cmd->text.len, cmd->text.pos, cmd->text.color
+            );
+            break;
+        case MU_COMMAND_RECT:
+            batch_draw_rect(&r->batch, cmd->rect.rect, cmd->rect.color);
+            break;
+        case MU_COMMAND_ICON:
+            batch_draw_icon(&r->batch, cmd->icon.id, cmd->icon.rect, cmd->icon.color);
+            break;
+        case MU_COMMAND_COLUMNS:
+            batch_draw_columns(
+                &r->batch, cmd->columns.rect, cmd->columns.spans, cmd->columns.color
+            );
+            break;
+        case MU_COMMAND_FRAME:
+            batch_draw_frame(
+                &r->batch,
+                cmd->frame.rect,
+                cmd->frame.color,
+                cmd->frame.border,
+                cmd->frame.border_width
+            );
+            break;
+        case MU_COMMAND_CLIP:
+            gl_set_clip_rect(r, cmd->clip.rect);
+            break;
+        }
+    }
+}
+
+static void gl_clear(renderer_t *base, mu_Color clr) {
+    gl_renderer_t *r = gl_bind(base);
+    flush_batch(&r->batch);
+    glClearColor(clr.r / 255., clr.g / 255., clr.b / 255., clr.a / 255.);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
 
-    glTexCoordPointer(2, GL_FLOAT, 0, tex_buf);
-    glVertexPointer(2, GL_FLOAT, 0, vert_buf);
-    glColorPointer(4, GL_UNSIGNED_BYTE, 0, color_buf);
-    glDrawElements(GL_TRIANGLES, buf_idx * 6, GL_UNSIGNED_INT, index_buf);
+static void gl_present(renderer_t *base) {
+    gl_renderer_t *r = gl_bind(base);
+    flush_batch(&r->batch);
+    SDL_GL_SwapWindow(r->window);
+}
 
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
+static const renderer_backend_t gl_backend = {
+    "window", 1, gl_create, gl_destroy, gl_clear, gl_render, gl_present, NULL
+};
 
-    buf_idx = 0;
-}
-
-static void push_quad(mu_Rect dst, mu_Rect src, mu_Color color) {
-    if (buf_idx == BUFFER_SIZE) {
-        flush();
-    }
-
-    int texvert_idx = buf_idx * 8;
-    int color_idx = buf_idx * 16;
-    int element_idx = buf_idx * 4;
-    int index_idx = buf_idx * 6;
-    buf_idx++;
-
-    /* update texture buffer */
-    float x = src.x / (float) ATLAS_WIDTH;
-    float y = src.y / (float) ATLAS_HEIGHT;
-    float w = src.w / (float) ATLAS_WIDTH;
-    float h = src.h / (float) ATLAS_HEIGHT;
-    tex_buf[texvert_idx + 0] = x;
-    tex_buf[texvert_idx + 1] = y;
-    tex_buf[texvert_idx + 2] = x + w;
-    tex_buf[texvert_idx + 3] = y;
-    tex_buf[texvert_idx + 4] = x;
-    tex_buf[texvert_idx + 5] = y + h;
-    tex_buf[texvert_idx + 6] = x + w;
-    tex_buf[texvert_idx + 7] = y + h;
-
-    /* update vertex buffer */
-    vert_buf[texvert_idx + 0] = dst.x;
-    vert_buf[texvert_idx + 1] = dst.y;
-    vert_buf[texvert_idx + 2] = dst.x + dst.w;
-    vert_buf[texvert_idx + 3] = dst.y;
-    vert_buf[texvert_idx + 4] = dst.x;
-    vert_buf[texvert_idx + 5] = dst.y + dst.h;
-    vert_buf[texvert_idx + 6] = dst.x + dst.w;
-    vert_buf[texvert_idx + 7] = dst.y + dst.h;
-
-    /* update color buffer */
-    memcpy(color_buf + color_idx + 0, &color, 4);
-    memcpy(color_buf + color_idx + 4, &color, 4);
-    memcpy(color_buf + color_idx + 8, &color, 4);
-    memcpy(color_buf + color_idx + 12, &color, 4);
-
-    /* update index buffer */
-    index_buf[index_idx + 0] = element_idx + 0;
-    index_buf[index_idx + 1] = element_idx + 1;
-    index_buf[index_idx + 2] = element_idx + 2;
-    index_buf[index_idx + 3] = element_idx + 2;
-    index_buf[index_idx + 4] = element_idx + 3;
-    index_buf[index_idx + 5] = element_idx + 1;
-}
-
-void r_draw_rect(mu_Rect rect, mu_Color color) {
-    push_quad(rect, atlas[ATLAS_WHITE], color);
-}
-
-void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color) {
-    mu_Rect dst = {pos.x, pos.y, 0, 0};
-    for (const char *p = text; *p; p++) {
-        if ((*p & 0xc0) == 0x80) {
-            continue;
-        }
-        int chr = mu_min((unsigned char) *p, 127);
-        mu_Rect src = atlas[ATLAS_FONT + chr];
-        dst.w = src.w;
-        dst.h = src.h;
-        push_quad(dst, src, color);
-        dst.x += dst.w;
+void r_set_scissor_clip(renderer_t *base, int enabled) {
+    if (base->backend != &gl_backend) {
+        return;
     }
+    gl_renderer_t *r = gl_bind(base);
+    flush_batch(&r->batch);
+    r->scissor_clip = enabled;
+    batch_set_clip(&r->batch, mu_rect(0, 0, 0x1000000, 0x1000000));
+    glScissor(0, 0, base->width, base->height);
 }
 
-void r_draw_icon(int id, mu_Rect rect, mu_Color color) {
-    mu_Rect src = atlas[id];
-    int x = rect.x + (rect.w - src.w) / 2;
-    int y = rect.y + (rect.h - src.h) / 2;
-    push_quad(mu_rect(x, y, src.w, src.h), src, color);
+void r_set_vertex_threads(renderer_t *base, int threads, int min_quads) {
+    if (base->backend != &gl_backend) {
+        return;
+    }
+    gl_renderer_t *r = (gl_renderer_t *) base;
+    batch_workers_destroy(r->workers);
+    r->workers = threads > 0 ? batch_workers_create(threads, min_quads) : NULL;
 }
 
-int r_get_text_width(const char *text, int len) {
-    int res = 0;
-    for (const char *p = text; *p && len--; p++) {
-        if ((*p & 0xc0) == 0x80) {
-            continue;
+/*============================================================================
+** gl3: OpenGL 3.3 core-profile instanced quads
+**============================================================================*/
+
+typedef struct
+{
+    renderer_t base;
+    SDL_Window *window;
+    SDL_GLContext context;
+    gl3_renderer_t *gl3;
+} gl3_backend_t;
+
+static const renderer_backend_t gl3_backend;
+
+static void gl3_backend_destroy(renderer_t *base) {
+    gl3_backend_t *r = (gl3_backend_t *) base;
+    gl3_destroy(r->gl3);
+    if (r->context) {
+        SDL_GL_DeleteContext(r->context);
+    }
+    if (r->window) {
+        SDL_DestroyWindow(r->window);
+    }
+    free(r);
+}
+
+static renderer_t *gl3_backend_create(int width, int height) {
+    gl3_backend_t *r = calloc(1, sizeof(gl3_backend_t));
+    if (!r) {
+        return NULL;
+    }
+    r->base = (renderer_t) {&gl3_backend, width, height};
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    r->window = SDL_CreateWindow(
+        NULL,
+        SDL_WINDOWPOS_UNDEFINED,
+        SDL_WINDOWPOS_UNDEFINED,
+        width,
+        height,
+        SDL_WINDOW_OPENGL
+    );
+    r->context = r->window ? SDL_GL_CreateContext(r->window) : NULL;
+    if (!r->context) {
+        fprintf(stderr, "GL3: cannot create a 3.3 core context: %s\n", SDL_GetError());
+        gl3_backend_destroy(&r->base);
+        return NULL;
+    }
+    if (!(r->gl3 = gl3_create(width, height, SDL_GL_GetProcAddress))) {
+        gl3_backend_destroy(&r->base);
+        return NULL;
+    }
+    return &r->base;
+}
+
+static gl3_backend_t *gl3_backend_bind(renderer_t *base) {
+    gl3_backend_t *r = (gl3_backend_t *) base;
+    SDL_GL_MakeCurrent(r->window, r->context);
+    return r;
+}
+
+static void gl3_backend_clear(renderer_t *base, mu_Color color) {
+    gl3_clear(gl3_backend_bind(base)->gl3, color);
+}
+
+static void gl3_backend_render(renderer_t *base, mu_Context *ctx) {
+    gl3_render(gl3_backend_bind(base)->gl3, ctx);
+}
+
+static void gl3_backend_present(renderer_t *base) {
+    gl3_backend_t *r = gl3_backend_bind(base);
+    gl3_flush(r->gl3);
+    SDL_GL_SwapWindow(r->window);
+}
+
+static const renderer_backend_t gl3_backend = {
+    "gl3",
+    1,
+    gl3_backend_create,
+    gl3_backend_destroy,
+    gl3_backend_clear,
+    gl3_backend_render,
+    gl3_backend_present,
+    NULL
+};
+
+/*============================================================================
+** software: CPU rasterizer
+**============================================================================*/
+
+typedef struct
+{
+    renderer_t base;
+    soft_renderer_t *sr;
+} soft_backend_t;
+
+static const renderer_backend_t soft_backend;
+
+static renderer_t *soft_backend_create(int width, int height) {
+    soft_backend_t *r = calloc(1, sizeof(soft_backend_t));
+    if (!r) {
+        return NULL;
+    }
+    r->base = (renderer_t) {&soft_backend, width, height};
+    if (!(r->sr = sr_create(width, height))) {
+        free(r);
+        return NULL;
+    }
+    return &r->base;
+}
+
+static void soft_backend_destroy(renderer_t *base) {
+    soft_backend_t *r = (soft_backend_t *) base;
+    sr_destroy(r->sr);
+    free(r);
+}
+
+static void soft_backend_clear(renderer_t *base, mu_Color color) {
+    sr_clear(((soft_backend_t *) base)->sr, color);
+}
+
+static void soft_backend_render(renderer_t *base, mu_Context *ctx) {
+    sr_render(((soft_backend_t *) base)->sr, ctx);
+}
+
+/* offscreen backends have nothing to present */
+static void offscreen_present(renderer_t *base) {
+    (void) base;
+}
+
+static int soft_backend_screenshot(renderer_t *base, const char *path) {
+    return sr_write_ppm(((soft_backend_t *) base)->sr, path);
+}
+
+static const renderer_backend_t soft_backend = {
+    "software",
+    0,
+    soft_backend_create,
+    soft_backend_destroy,
+    soft_backend_clear,
+    soft_backend_render,
+    offscreen_present,
+    soft_backend_screenshot
+};
+
+/*============================================================================
+** null: consumes the commands without drawing
+**============================================================================*/
+
+typedef struct
+{
+    renderer_t base;
+    unsigned checksum; // Keeps the walk from being optimized away
+} null_backend_t;
+
+static const renderer_backend_t null_backend;
+
+static renderer_t *null_backend_create(int width, int height) {
+    null_backend_t *r = calloc(1, sizeof(null_backend_t));
+    if (!r) {
+        return NULL;
+    }
+    r->base = (renderer_t) {&null_backend, width, height};
+    return &r->base;
+}
+
+static void null_backend_destroy(renderer_t *base) {
+    free(base);
+}
+
+static void null_backend_clear(renderer_t *base, mu_Color color) {
+    (void) base;
+    (void) color;
+}
+
+static void null_backend_render(renderer_t *base, mu_Context *ctx) {
+    null_backend_t *r = (null_backend_t *) base;
+    unsigned checksum = r->checksum;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        switch (cmd->type) {
+        case MU_COMMAND_TEXT:
+            checksum += cmd->text.pos.x + cmd->text.pos.y + cmd->text.len;
+            break;
+        case MU_COMMAND_RECT:
+            checksum += cmd->rect.rect.x + cmd->rect.rect.w + cmd->rect.color.r;
+            break;
+        case MU_COMMAND_ICON:
+            checksum += cmd->icon.id + cmd->icon.rect.x;
+            break;
+        case MU_COMMAND_COLUMNS:
+            checksum += cmd->columns.rect.x + cmd->columns.rect.w + cmd->columns.spans[0];
+            break;
+        case MU_COMMAND_FRAME:
+            checksum += cmd->frame.rect.x + cmd->frame.rect.w + cmd->frame.color.r;
+            break;
+        case MU_COMMAND_CLIP:
+            checksum += cmd->clip.rect.x + cmd->clip.rect.h;
+            break;
         }
-        int chr = mu_min((unsigned char) *p, 127);
-        res += atlas[ATLAS_FONT + chr].w;
     }
-    return res;
+    r->checksum = checksum;
 }
 
-int r_get_text_height(void) {
-    return 18;
+static const renderer_backend_t null_backend = {
+    "null",
+    0,
+    null_backend_create,
+    null_backend_destroy,
+    null_backend_clear,
+    null_backend_render,
+    offscreen_present,
+    NULL
+};
+
+/*============================================================================
+** renderer interface
+**============================================================================*/
+
+static const renderer_backend_t *backends[] = {
+    &gl_backend,
+    &gl3_backend,
+    &soft_backend,
+    &null_backend,
+};
+
+const renderer_backend_t *r_find_backend(const char *mode) {
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strcmp(backends[i]->name, mode) == 0) {
+            return backends[i];
+        }
+    }
+    return NULL;
 }
 
-void r_set_clip_rect(mu_Rect rect) {
-    flush();
-    glScissor(rect.x, height - (rect.y + rect.h), rect.w, rect.h);
+renderer_t *r_create(const char *mode, int width, int height) {
+    const renderer_backend_t *backend = r_find_backend(mode);
+    if (!backend) {
+        fprintf(stderr, "Renderer: unknown mode '%s'\n", mode);
+        return NULL;
+    }
+    return backend->create(width, height);
 }
 
-void r_clear(mu_Color clr) {
-    flush();
-    glClearColor(clr.r / 255., clr.g / 255., clr.b / 255., clr.a / 255.);
-    glClear(GL_COLOR_BUFFER_BIT);
+void r_destroy(renderer_t *r) {
+    if (r) {
+        r->backend->destroy(r);
+    }
+}
+
+void r_clear(renderer_t *r, mu_Color color) {
+    r->backend->clear(r, color);
+}
+
+void r_render(renderer_t *r, mu_Context *ctx) {
+    r->backend->render(r, ctx);
+}
+
+void r_present(renderer_t *r) {
+    r->backend->present(r);
+}
+
+int r_screenshot(renderer_t *r, const char *path) {
+    return r->backend->screenshot ? r->backend->screenshot(r, path) : -1;
 }
 
-void r_present(void) {
-    flush();
-    SDL_GL_SwapWindow(window);
+int r_get_text_width(const char *text, int len) {
+    return batch_text_width(text, len);
+}
+
+int r_get_text_height(void) {
+    return batch_text_height();
 }
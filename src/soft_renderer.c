@@ -0,0 +1,764 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "soft_renderer.h"
+#include "atlas.inl"
+#include "glyph_atlas.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SR_X86 1
+#include <immintrin.h>
+#define SR_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Glyphs and icons are drawn from the glyph atlas texture, whose first
+// pages hold the baked atlas at the same texel coordinates
+_Static_assert(
+    sizeof(atlas_texture) <= GA_TEXTURE_WIDTH * GA_TEXTURE_HEIGHT,
+    "baked atlas must fit the glyph atlas texture"
+);
+
+// Span kernels. `src` is a packed pixel whose alpha byte already holds the
+// blend alpha `a`; `rgb` has its alpha byte cleared and takes its alpha
+// per pixel from div255(a * mask[i]). Every implementation must produce
+// the same bytes as the scalar one.
+struct sr_kernels
+{
+    sr_isa_t isa;
+    void (*fill)(uint32_t *dst, int n, uint32_t color);
+    void (*blend)(uint32_t *dst, int n, uint32_t src, unsigned a);
+    void (*blend_mask)(uint32_t *dst, int n, uint32_t rgb, unsigned a, const uint8_t *mask);
+};
+
+static uint32_t pack_color(mu_Color color) {
+    uint32_t px;
+    memcpy(&px, &color, sizeof(px));
+    return px;
+}
+
+// The bits of the alpha byte within a packed pixel, independent of byte order
+static uint32_t alpha_bits(void) {
+    return pack_color(mu_color(0, 0, 0, 255));
+}
+
+// Exact round(x / 255) for x <= 255 * 255
+static inline unsigned div255(unsigned x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t blend_pixel(uint32_t dst, uint32_t src, unsigned a) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        unsigned s = (src >> shift) & 0xff;
+        unsigned d = (dst >> shift) & 0xff;
+        out |= (uint32_t) div255(s * a + d * (255 - a)) << shift;
+    }
+    return out;
+}
+
+/*============================================================================
+** scalar reference kernels
+**============================================================================*/
+
+static void fill_scalar(uint32_t *dst, int n, uint32_t color) {
+    for (int i = 0; i < n; i++) {
+        dst[i] = color;
+    }
+}
+
+static void blend_scalar(uint32_t *dst, int n, uint32_t src, unsigned a) {
+    for (int i = 0; i < n; i++) {
+        dst[i] = blend_pixel(dst[i], src, a);
+    }
+}
+
+static void
+blend_mask_scalar(uint32_t *dst, int n, uint32_t rgb, unsigned a, const uint8_t *mask) {
+    uint32_t abits = alpha_bits();
+    for (int i = 0; i < n; i++) {
+        if (mask[i]) {
+            unsigned pa = div255(a * mask[i]);
+            dst[i] = blend_pixel(dst[i], rgb | (abits & (pa * 0x01010101u)), pa);
+        }
+    }
+}
+
+static const sr_kernels_t kernels_scalar = {
+    SR_ISA_SCALAR,
+    fill_scalar,
+    blend_scalar,
+    blend_mask_scalar
+};
+
+#ifdef SR_X86
+
+/*============================================================================
+** SSE2 kernels: 4 pixels per step, channels widened to 16 bits
+**============================================================================*/
+
+SR_TARGET("sse2") static inline __m128i div255_sse2(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// s * a + d * (255 - a) for two pixels, all operands 16 bits per channel
+SR_TARGET("sse2") static inline __m128i blend_sse2(__m128i d, __m128i s, __m128i a) {
+    __m128i ia = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return div255_sse2(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, ia)));
+}
+
+SR_TARGET("sse2") static void fill_sse2(uint32_t *dst, int n, uint32_t color) {
+    __m128i c = _mm_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i *) (dst + i), c);
+    }
+    fill_scalar(dst + i, n - i, color);
+}
+
+SR_TARGET("sse2") static void blend_sse2_span(uint32_t *dst, int n, uint32_t src, unsigned a) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i s = _mm_unpacklo_epi8(_mm_set1_epi32((int) src), zero);
+    __m128i av = _mm_set1_epi16((short) a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i lo = blend_sse2(_mm_unpacklo_epi8(d, zero), s, av);
+        __m128i hi = blend_sse2(_mm_unpackhi_epi8(d, zero), s, av);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blend_scalar(dst + i, n - i, src, a);
+}
+
+SR_TARGET("sse2")
+static void blend_mask_sse2(uint32_t *dst, int n, uint32_t rgb, unsigned a, const uint8_t *mask) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i s = _mm_unpacklo_epi8(_mm_set1_epi32((int) rgb), zero);
+    __m128i abits = _mm_unpacklo_epi8(_mm_set1_epi32((int) alpha_bits()), zero);
+    __m128i av = _mm_set1_epi16((short) a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t m;
+        memcpy(&m, mask + i, sizeof(m));
+        if (!m) {
+            continue;
+        }
+        /* per-pixel alpha, then broadcast each one over its four channels */
+        __m128i pa = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) m), zero);
+        pa = div255_sse2(_mm_mullo_epi16(pa, av));
+        pa = _mm_unpacklo_epi16(pa, pa);
+        __m128i pa_lo = _mm_unpacklo_epi32(pa, pa);
+        __m128i pa_hi = _mm_unpackhi_epi32(pa, pa);
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i s_lo = _mm_or_si128(s, _mm_and_si128(abits, pa_lo));
+        __m128i s_hi = _mm_or_si128(s, _mm_and_si128(abits, pa_hi));
+        __m128i lo = blend_sse2(_mm_unpacklo_epi8(d, zero), s_lo, pa_lo);
+        __m128i hi = blend_sse2(_mm_unpackhi_epi8(d, zero), s_hi, pa_hi);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blend_mask_scalar(dst + i, n - i, rgb, a, mask + i);
+}
+
+static const sr_kernels_t kernels_sse2 = {SR_ISA_SSE2, fill_sse2, blend_sse2_span, blend_mask_sse2};
+
+/*============================================================================
+** AVX2 kernels: 8 pixels per step. Unpacks and packs work within 128-bit
+** lanes, so the low half holds pixels 0-1 and 4-5, the high half 2-3 and 6-7.
+**============================================================================*/
+
+SR_TARGET("avx2") static inline __m256i div255_avx2(__m256i x) {
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+SR_TARGET("avx2") static inline __m256i blend_avx2(__m256i d, __m256i s, __m256i a) {
+    __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return div255_avx2(_mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, ia)));
+}
+
+SR_TARGET("avx2") static void fill_avx2(uint32_t *dst, int n, uint32_t color) {
+    __m256i c = _mm256_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_si256((__m256i *) (dst + i), c);
+    }
+    fill_scalar(dst + i, n - i, color);
+}
+
+SR_TARGET("avx2") static void blend_avx2_span(uint32_t *dst, int n, uint32_t src, unsigned a) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i s = _mm256_unpacklo_epi8(_mm256_set1_epi32((int) src), zero);
+    __m256i av = _mm256_set1_epi16((short) a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i lo = blend_avx2(_mm256_unpacklo_epi8(d, zero), s, av);
+        __m256i hi = blend_avx2(_mm256_unpackhi_epi8(d, zero), s, av);
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    blend_scalar(dst + i, n - i, src, a);
+}
+
+SR_TARGET("avx2")
+static void blend_mask_avx2(uint32_t *dst, int n, uint32_t rgb, unsigned a, const uint8_t *mask) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i s = _mm256_unpacklo_epi8(_mm256_set1_epi32((int) rgb), zero);
+    __m256i abits = _mm256_unpacklo_epi8(_mm256_set1_epi32((int) alpha_bits()), zero);
+    __m256i av = _mm256_set1_epi32((int) a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t m;
+        memcpy(&m, mask + i, sizeof(m));
+        if (!m) {
+            continue;
+        }
+        /* one 32-bit lane per pixel holding its alpha in both 16-bit halves */
+        __m256i pa = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (mask + i)));
+        pa = div255_avx2(_mm256_mullo_epi16(pa, av));
+        pa = _mm256_or_si256(pa, _mm256_slli_epi32(pa, 16));
+        __m256i pa_lo = _mm256_unpacklo_epi32(pa, pa);
+        __m256i pa_hi = _mm256_unpackhi_epi32(pa, pa);
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i s_lo = _mm256_or_si256(s, _mm256_and_si256(abits, pa_lo));
+        __m256i s_hi = _mm256_or_si256(s, _mm256_and_si256(abits, pa_hi));
+        __m256i lo = blend_avx2(_mm256_unpacklo_epi8(d, zero), s_lo, pa_lo);
+        __m256i hi = blend_avx2(_mm256_unpackhi_epi8(d, zero), s_hi, pa_hi);
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    /* glyph rows are mostly narrower than 8 pixels */
+    blend_mask_sse2(dst + i, n - i, rgb, a, mask + i);
+}
+
+static const sr_kernels_t kernels_avx2 = {SR_ISA_AVX2, fill_avx2, blend_avx2_span, blend_mask_avx2};
+
+#endif // SR_X86
+
+/*============================================================================
+** dispatch
+**============================================================================*/
+
+static int isa_supported(sr_isa_t isa) {
+    switch (isa) {
+    case SR_ISA_SCALAR:
+        return 1;
+#ifdef SR_X86
+    case SR_ISA_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case SR_ISA_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+static const sr_kernels_t *isa_kernels(sr_isa_t isa) {
+    switch (isa) {
+#ifdef SR_X86
+    case SR_ISA_SSE2:
+        return &kernels_sse2;
+    case SR_ISA_AVX2:
+        return &kernels_avx2;
+#endif
+    default:
+        return &kernels_scalar;
+    }
+}
+
+sr_isa_t sr_set_isa(soft_renderer_t *sr, sr_isa_t isa) {
+    if (isa == SR_ISA_AUTO) {
+        isa = SR_ISA_AVX2;
+    }
+    while (!isa_supported(isa)) {
+        isa--;
+    }
+    sr->isa = isa;
+    sr->kernels = isa_kernels(isa);
+    return isa;
+}
+
+const char *sr_isa_name(sr_isa_t isa) {
+    switch (isa) {
+    case SR_ISA_AUTO:
+        return "auto";
+    case SR_ISA_SCALAR:
+        return "scalar";
+    case SR_ISA_SSE2:
+        return "sse2";
+    case SR_ISA_AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+/*============================================================================
+** drawing
+**============================================================================*/
+
+soft_renderer_t *sr_create(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return NULL;
+    }
+    soft_renderer_t *sr = calloc(1, sizeof(soft_renderer_t));
+    if (!sr) {
+        return NULL;
+    }
+    sr->pixels = calloc((size_t) width * height, sizeof(uint32_t));
+    sr->glyphs = ga_create(GA_MAX_PAGES);
+    if (!sr->pixels || !sr->glyphs) {
+        ga_destroy(sr->glyphs);
+        free(sr->pixels);
+        free(sr);
+        return NULL;
+    }
+    sr->width = width;
+    sr->height = height;
+    sr->clip = mu_rect(0, 0, width, height);
+    sr_set_isa(sr, SR_ISA_AUTO);
+    return sr;
+}
+
+void sr_destroy(soft_renderer_t *sr) {
+    if (sr) {
+        sr_set_threads(sr, 0);
+        ga_destroy(sr->glyphs);
+        free(sr->pixels);
+        free(sr);
+    }
+}
+
+static mu_Rect intersect_rects(mu_Rect r1, mu_Rect r2) {
+    int x1 = mu_max(r1.x, r2.x);
+    int y1 = mu_max(r1.y, r2.y);
+    int x2 = mu_min(r1.x + r1.w, r2.x + r2.w);
+    int y2 = mu_min(r1.y + r1.h, r2.y + r2.h);
+    return mu_rect(x1, y1, mu_max(0, x2 - x1), mu_max(0, y2 - y1));
+}
+
+/* draws `src` from the glyph atlas texture, whose first pages hold the baked
+** atlas, at `dst` (same size), modulated by `color` */
+static void blit_atlas(soft_renderer_t *sr, mu_Rect dst, mu_Rect src, mu_Color color) {
+    mu_Rect r = intersect_rects(dst, sr->clip);
+    if (r.w <= 0 || r.h <= 0 || color.a == 0) {
+        return;
+    }
+    uint32_t rgb = pack_color(mu_color(color.r, color.g, color.b, 0));
+    const uint8_t *mask = ga_texture(sr->glyphs) + (src.y + r.y - dst.y) * GA_TEXTURE_WIDTH +
+                          src.x + r.x - dst.x;
+    uint32_t *row = sr->pixels + r.y * sr->width + r.x;
+    for (int y = 0; y < r.h; y++) {
+        sr->kernels->blend_mask(row, r.w, rgb, color.a, mask);
+        mask += GA_TEXTURE_WIDTH;
+        row += sr->width;
+    }
+}
+
+void sr_draw_rect(soft_renderer_t *sr, mu_Rect rect, mu_Color color) {
+    mu_Rect r = intersect_rects(rect, sr->clip);
+    if (r.w <= 0 || r.h <= 0 || color.a == 0) {
+        return;
+    }
+    uint32_t src = pack_color(color);
+    uint32_t *row = sr->pixels + r.y * sr->width + r.x;
+    for (int y = 0; y < r.h; y++) {
+        if (color.a == 255) {
+            sr->kernels->fill(row, r.w, src);
+        }
+        else {
+            sr->kernels->blend(row, r.w, src, color.a);
+        }
+        row += sr->width;
+    }
+}
+
+void sr_draw_text(soft_renderer_t *sr, const char *text, int len, mu_Vec2 pos, mu_Color color) {
+    mu_Rect dst = {pos.x, pos.y, 0, 0};
+    if (len < 0) {
+        len = INT_MAX;
+    }
+    for (const char *p = text; p - text < len && *p;) {
+        mu_Rect src;
+        ga_next_glyph(sr->glyphs, &p, len - (p - text), &src);
+        dst.w = src.w;
+        dst.h = src.h;
+        blit_atlas(sr, dst, src, color);
+        dst.x += dst.w;
+    }
+}
+
+void sr_draw_icon(soft_renderer_t *sr, int id, mu_Rect rect, mu_Color color) {
+    mu_Rect src = atlas[id];
+    int x = rect.x + (rect.w - src.w) / 2;
+    int y = rect.y + (rect.h - src.h) / 2;
+    blit_atlas(sr, mu_rect(x, y, src.w, src.h), src, color);
+}
+
+void sr_draw_columns(
+    soft_renderer_t *sr,
+    mu_Rect rect,
+    const unsigned short *spans,
+    mu_Color color
+) {
+    mu_Rect run;
+    for (int i = 0; mu_next_column_run(rect, spans, &i, &run);) {
+        sr_draw_rect(sr, run, color);
+    }
+}
+
+void sr_draw_frame(
+    soft_renderer_t *sr,
+    mu_Rect rect,
+    mu_Color color,
+    mu_Color border,
+    int border_width
+) {
+    mu_Rect rects[5];
+    mu_frame_rects(rect, border_width, rects);
+    sr_draw_rect(sr, rects[0], color);
+    for (int i = 1; i < 5; i++) {
+        sr_draw_rect(sr, rects[i], border);
+    }
+}
+
+int sr_get_text_width(const char *text, int len) {
+    return ga_text_width(text, len);
+}
+
+int sr_get_text_height(void) {
+    return 18;
+}
+
+void sr_set_clip_rect(soft_renderer_t *sr, mu_Rect rect) {
+    sr->clip = intersect_rects(rect, mu_rect(0, 0, sr->width, sr->height));
+}
+
+void sr_clear(soft_renderer_t *sr, mu_Color color) {
+    sr->kernels->fill(sr->pixels, sr->width * sr->height, pack_color(color));
+}
+
+static void draw_command(soft_renderer_t *sr, const mu_Command *cmd) {
+    switch (cmd->type) {
+    case MU_COMMAND_TEXT:
+        sr_draw_text(sr, mu_text_str(&cmd->text), cmd->text.len, cmd->text.pos, cmd->text.color);
+        break;
+    case MU_COMMAND_RECT:
+        sr_draw_rect(sr, cmd->rect.rect, cmd->rect.color);
+        break;
+    case MU_COMMAND_ICON:
+        sr_draw_icon(sr, cmd->icon.id, cmd->icon.rect, cmd->icon.color);
+        break;
+    case MU_COMMAND_COLUMNS:
+        sr_draw_columns(sr, cmd->columns.rect, cmd->columns.spans, cmd->columns.color);
+        break;
+    case MU_COMMAND_FRAME:
+        sr_draw_frame(
+            sr, cmd->frame.rect, cmd->frame.color, cmd->frame.border, cmd->frame.border_width
+        );
+        break;
+    case MU_COMMAND_CLIP:
+        sr_set_clip_rect(sr, cmd->clip.rect);
+        break;
+    }
+}
+
+/*============================================================================
+** tiled rendering
+**============================================================================*/
+
+typedef struct
+{
+    const mu_Command *cmd;
+    mu_Rect clip;   // Clip state the command was issued under
+    mu_Rect bounds; // Pixels it can touch: its extent within `clip`
+} sr_binned_t;
+
+struct sr_tiles
+{
+    int cols, rows;
+
+    /* per-frame bins, stored as one index array sliced by `offsets` */
+    sr_binned_t *cmds;
+    int cmd_count, cmd_capacity;
+    int *indices;
+    int index_capacity;
+    int *offsets; // cols * rows + 1 entries
+    int *cursor;  // cols * rows entries
+
+    /* worker pool; each dispatch bumps `generation` */
+    soft_renderer_t *sr;
+    pthread_t *workers;
+    int worker_count;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned generation;
+    int pending;
+    bool quit;
+    atomic_int next_tile;
+};
+
+static mu_Rect command_bounds(const mu_Command *cmd) {
+    switch (cmd->type) {
+    case MU_COMMAND_RECT:
+        return cmd->rect.rect;
+    case MU_COMMAND_COLUMNS:
+        return cmd->columns.rect;
+    case MU_COMMAND_FRAME:
+        return cmd->frame.rect;
+    case MU_COMMAND_ICON: {
+        mu_Rect src = atlas[cmd->icon.id];
+        mu_Rect rect = cmd->icon.rect;
+        return mu_rect(rect.x + (rect.w - src.w) / 2, rect.y + (rect.h - src.h) / 2, src.w, src.h);
+    }
+    case MU_COMMAND_TEXT: {
+        int w = 0, h = 0;
+        const char *text = mu_text_str(&cmd->text);
+        /* accented glyphs are as large as their base letters */
+        for (const char *p = text; p - text < cmd->text.len && *p;) {
+            mu_Rect src = atlas[ATLAS_FONT + ga_next_baked(&p, cmd->text.len - (p - text))];
+            w += src.w;
+            h = mu_max(h, src.h);
+        }
+        return mu_rect(cmd->text.pos.x, cmd->text.pos.y, w, h);
+    }
+    }
+    return mu_rect(0, 0, 0, 0);
+}
+
+static void *grow(void *items, int *capacity, int needed, size_t size) {
+    if (needed <= *capacity) {
+        return items;
+    }
+    int n = mu_max(needed, *capacity * 2);
+    void *res = realloc(items, n * size);
+    if (res) {
+        *capacity = n;
+    }
+    return res;
+}
+
+/* collects the visible draw commands with their clip rects and sorts their
+** indices into per-tile lists; returns 0 on success */
+static int bin_commands(soft_renderer_t *sr, mu_Context *ctx) {
+    sr_tiles_t *t = sr->tiles;
+    int tile_count = t->cols * t->rows;
+    memset(t->offsets, 0, (tile_count + 1) * sizeof(int));
+    t->cmd_count = 0;
+
+    /* pass 1: record commands and count entries per tile */
+    int entries = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        if (cmd->type == MU_COMMAND_CLIP) {
+            sr_set_clip_rect(sr, cmd->clip.rect);
+            continue;
+        }
+        mu_Rect r = intersect_rects(command_bounds(cmd), sr->clip);
+        if (r.w <= 0 || r.h <= 0) {
+            continue;
+        }
+        sr_binned_t *cmds = grow(t->cmds, &t->cmd_capacity, t->cmd_count + 1, sizeof(*cmds));
+        if (!cmds) {
+            return -1;
+        }
+        t->cmds = cmds;
+        cmds[t->cmd_count++] = (sr_binned_t) {cmd, sr->clip, r};
+        for (int y = r.y / SR_TILE_SIZE; y <= (r.y + r.h - 1) / SR_TILE_SIZE; y++) {
+            for (int x = r.x / SR_TILE_SIZE; x <= (r.x + r.w - 1) / SR_TILE_SIZE; x++) {
+                t->offsets[y * t->cols + x + 1]++;
+                entries++;
+            }
+        }
+    }
+
+    /* pass 2: prefix sums, then fill the lists in command order */
+    int *indices = grow(t->indices, &t->index_capacity, entries, sizeof(int));
+    if (!indices) {
+        return -1;
+    }
+    t->indices = indices;
+    for (int i = 0; i < tile_count; i++) {
+        t->offsets[i + 1] += t->offsets[i];
+        t->cursor[i] = t->offsets[i];
+    }
+    for (int i = 0; i < t->cmd_count; i++) {
+        mu_Rect r = t->cmds[i].bounds;
+        for (int y = r.y / SR_TILE_SIZE; y <= (r.y + r.h - 1) / SR_TILE_SIZE; y++) {
+            for (int x = r.x / SR_TILE_SIZE; x <= (r.x + r.w - 1) / SR_TILE_SIZE; x++) {
+                indices[t->cursor[y * t->cols + x]++] = i;
+            }
+        }
+    }
+    return 0;
+}
+
+static void render_tile(soft_renderer_t *sr, int tile) {
+    sr_tiles_t *t = sr->tiles;
+    mu_Rect rect = mu_rect(
+        tile % t->cols * SR_TILE_SIZE,
+        tile / t->cols * SR_TILE_SIZE,
+        SR_TILE_SIZE,
+        SR_TILE_SIZE
+    );
+
+    /* a view sharing the framebuffer, clipped to this tile */
+    soft_renderer_t view = *sr;
+    for (int i = t->offsets[tile]; i < t->offsets[tile + 1]; i++) {
+        const sr_binned_t *b = &t->cmds[t->indices[i]];
+        view.clip = intersect_rects(b->clip, rect);
+        draw_command(&view, b->cmd);
+    }
+}
+
+static void render_tiles(sr_tiles_t *t) {
+    int tile_count = t->cols * t->rows;
+    int tile;
+    while ((tile = atomic_fetch_add(&t->next_tile, 1)) < tile_count) {
+        render_tile(t->sr, tile);
+    }
+}
+
+static void *worker_main(void *arg) {
+    sr_tiles_t *t = arg;
+    unsigned seen = 0;
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        while (t->generation == seen && !t->quit) {
+            pthread_cond_wait(&t->wake, &t->lock);
+        }
+        if (t->quit) {
+            break;
+        }
+        seen = t->generation;
+        pthread_mutex_unlock(&t->lock);
+        render_tiles(t);
+        pthread_mutex_lock(&t->lock);
+        if (--t->pending == 0) {
+            pthread_cond_signal(&t->done);
+        }
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+static void destroy_tiles(sr_tiles_t *t) {
+    pthread_mutex_lock(&t->lock);
+    t->quit = true;
+    pthread_cond_broadcast(&t->wake);
+    pthread_mutex_unlock(&t->lock);
+    for (int i = 0; i < t->worker_count; i++) {
+        pthread_join(t->workers[i], NULL);
+    }
+    pthread_cond_destroy(&t->done);
+    pthread_cond_destroy(&t->wake);
+    pthread_mutex_destroy(&t->lock);
+    free(t->workers);
+    free(t->cmds);
+    free(t->indices);
+    free(t->offsets);
+    free(t->cursor);
+    free(t);
+}
+
+static sr_tiles_t *create_tiles(soft_renderer_t *sr, int threads) {
+    sr_tiles_t *t = calloc(1, sizeof(sr_tiles_t));
+    if (!t) {
+        return NULL;
+    }
+    t->cols = (sr->width + SR_TILE_SIZE - 1) / SR_TILE_SIZE;
+    t->rows = (sr->height + SR_TILE_SIZE - 1) / SR_TILE_SIZE;
+    t->offsets = calloc(t->cols * t->rows + 1, sizeof(int));
+    t->cursor = calloc(t->cols * t->rows, sizeof(int));
+    t->workers = calloc(threads, sizeof(pthread_t));
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->wake, NULL);
+    pthread_cond_init(&t->done, NULL);
+    if (!t->offsets || !t->cursor || !t->workers) {
+        destroy_tiles(t);
+        return NULL;
+    }
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&t->workers[i], NULL, worker_main, t) != 0) {
+            destroy_tiles(t);
+            return NULL;
+        }
+        t->worker_count++;
+    }
+    return t;
+}
+
+int sr_set_threads(soft_renderer_t *sr, int threads) {
+    if (sr->tiles) {
+        destroy_tiles(sr->tiles);
+        sr->tiles = NULL;
+    }
+    sr->threads = 0;
+    if (threads <= 0) {
+        return 0;
+    }
+    sr->tiles = create_tiles(sr, threads);
+    if (!sr->tiles) {
+        return -1;
+    }
+    sr->threads = threads;
+    return 0;
+}
+
+static void render_tiled(soft_renderer_t *sr) {
+    sr_tiles_t *t = sr->tiles;
+    pthread_mutex_lock(&t->lock);
+    t->sr = sr;
+    atomic_store(&t->next_tile, 0);
+    t->pending = t->worker_count;
+    t->generation++;
+    pthread_cond_broadcast(&t->wake);
+    pthread_mutex_unlock(&t->lock);
+
+    render_tiles(t);
+
+    pthread_mutex_lock(&t->lock);
+    while (t->pending > 0) {
+        pthread_cond_wait(&t->done, &t->lock);
+    }
+    pthread_mutex_unlock(&t->lock);
+}
+
+void sr_render(soft_renderer_t *sr, mu_Context *ctx) {
+    ga_begin_frame(sr->glyphs);
+    if (sr->tiles) {
+        mu_Rect clip = sr->clip;
+        if (bin_commands(sr, ctx) == 0) {
+            render_tiled(sr);
+            return;
+        }
+        /* out of memory while binning: fall back to drawing directly */
+        sr->clip = clip;
+    }
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        draw_command(sr, cmd);
+    }
+}
+
+int sr_write_ppm(const soft_renderer_t *sr, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return -1;
+    }
+    fprintf(fp, "P6\n%d %d\n255\n", sr->width, sr->height);
+    const uint8_t *px = (const uint8_t *) sr->pixels;
+    for (int i = 0; i < sr->width * sr->height; i++, px += 4) {
+        fwrite(px, 1, 3, fp);
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "trace.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TRACE_BUFFER_EVENTS 8192
+#define TRACE_FLUSH_INTERVAL_NS 10000000 // 10ms
+
+typedef struct
+{
+    const char *name;
+    uint64_t ts;  // Monotonic wall time, ns
+    uint64_t tts; // Thread CPU time, ns
+    char phase;   // 'B'egin, 'E'nd or 'M'etadata (thread name)
+} trace_event_t;
+
+// Single-producer/single-consumer ring: the owning thread advances `head`,
+// the flusher thread advances `tail`. Buffers are never freed so a thread
+// racing a shutdown can't write into released memory; they are reused by
+// the next session and released with the process.
+typedef struct trace_buffer trace_buffer_t;
+struct trace_buffer
+{
+    trace_event_t events[TRACE_BUFFER_EVENTS];
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_uint dropped;
+    int tid;
+    trace_buffer_t *next;
+};
+
+atomic_bool trace_active = false;
+
+static _Atomic(trace_buffer_t *) buffers = NULL;
+static atomic_int next_tid = 0;
+static _Thread_local trace_buffer_t *local_buffer = NULL;
+
+static FILE *trace_file = NULL;
+static pthread_t flusher;
+static atomic_bool flusher_stop = false;
+static long written = 0;
+static uint64_t epoch = 0;
+static int pid = 0;
+static bool atexit_installed = false;
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static trace_buffer_t *get_buffer(void) {
+    if (!local_buffer) {
+        trace_buffer_t *buf = calloc(1, sizeof(trace_buffer_t));
+        if (!buf) {
+            return NULL;
+        }
+        buf->tid = atomic_fetch_add(&next_tid, 1) + 1;
+
+        // Lock-free push onto the registry walked by the flusher
+        trace_buffer_t *head = atomic_load(&buffers);
+        do {
+            buf->next = head;
+        } while (!atomic_compare_exchange_weak(&buffers, &head, buf));
+        local_buffer = buf;
+    }
+    return local_buffer;
+}
+
+static void push_event(const char *name, char phase) {
+    trace_buffer_t *buf = get_buffer();
+    if (!buf) {
+        return;
+    }
+
+    unsigned head = atomic_load_explicit(&buf->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&buf->tail, memory_order_acquire);
+    if (head - tail >= TRACE_BUFFER_EVENTS) {
+        atomic_fetch_add_explicit(&buf->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    trace_event_t *e = &buf->events[head % TRACE_BUFFER_EVENTS];
+    e->name = name;
+    e->phase = phase;
+    e->ts = clock_ns(CLOCK_MONOTONIC);
+    e->tts = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    atomic_store_explicit(&buf->head, head + 1, memory_order_release);
+}
+
+void trace_begin_event(const char *name) {
+    push_event(name, 'B');
+}
+
+void trace_end_event(const char *name) {
+    push_event(name, 'E');
+}
+
+void trace_set_thread_name(const char *name) {
+    if (atomic_load_explicit(&trace_active, memory_order_relaxed)) {
+        push_event(name, 'M');
+    }
+}
+
+static void write_event(const trace_buffer_t *buf, const trace_event_t *e) {
+    fprintf(trace_file, written++ ? ",\n" : "\n");
+    if (e->phase == 'M') {
+        fprintf(
+            trace_file,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            pid,
+            buf->tid,
+            e->name
+        );
+        return;
+    }
+    fprintf(
+        trace_file,
+        "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"tts\":%.3f,\"pid\":%d,\"tid\":%d}",
+        e->name,
+        e->phase,
+        e->ts > epoch ? (e->ts - epoch) / 1000.0 : 0.0,
+        e->tts / 1000.0,
+        pid,
+        buf->tid
+    );
+}
+
+// Drains every registered buffer; `discard` drops the events instead, which
+// is used to clear events left over from a previous session
+static void drain(bool discard) {
+    for (trace_buffer_t *buf = atomic_load(&buffers); buf; buf = buf->next) {
+        unsigned head = atomic_load_explicit(&buf->head, memory_order_acquire);
+        unsigned tail = atomic_load_explicit(&buf->tail, memory_order_relaxed);
+        while (!discard && tail != head) {
+            write_event(buf, &buf->events[tail % TRACE_BUFFER_EVENTS]);
+            tail++;
+        }
+        atomic_store_explicit(&buf->tail, head, memory_order_release);
+    }
+    if (!discard) {
+        fflush(trace_file);
+    }
+}
+
+static void *flusher_main(void *arg) {
+    struct timespec interval = {0, TRACE_FLUSH_INTERVAL_NS};
+    (void) arg;
+    while (!atomic_load(&flusher_stop)) {
+        drain(false);
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+int trace_init(const char *path) {
+    if (atomic_load(&trace_active) || !path || !*path) {
+        return -1;
+    }
+
+    trace_file = fopen(path, "w");
+    if (!trace_file) {
+        fprintf(stderr, "Trace: cannot open %s for writing\n", path);
+        return -1;
+    }
+    fprintf(trace_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    drain(true);
+    written = 0;
+    epoch = clock_ns(CLOCK_MONOTONIC);
+    pid = (int) getpid();
+    atomic_store(&flusher_stop, false);
+    if (pthread_create(&flusher, NULL, flusher_main, NULL) != 0) {
+        fclose(trace_file);
+        trace_file = NULL;
+        return -1;
+    }
+    atomic_store(&trace_active, true);
+    return 0;
+}
+
+int trace_init_from_env(void) {
+    const char *path = getenv(TRACE_ENV);
+    if (!path || !*path) {
+        return -1;
+    }
+    if (trace_init(path) != 0) {
+        return -1;
+    }
+    if (!atexit_installed) {
+        atexit(trace_shutdown);
+        atexit_installed = true;
+    }
+    return 0;
+}
+
+void trace_shutdown(void) {
+    if (!atomic_exchange(&trace_active, false)) {
+        return;
+    }
+
+    atomic_store(&flusher_stop, true);
+    pthread_join(flusher, NULL);
+    drain(false);
+
+    unsigned dropped = 0;
+    for (trace_buffer_t *buf = atomic_load(&buffers); buf; buf = buf->next) {
+        dropped += atomic_exchange(&buf->dropped, 0);
+    }
+    if (dropped) {
+        fprintf(stderr, "Trace: dropped %u events (per-thread buffer full)\n", dropped);
+    }
+
+    fprintf(trace_file, "\n]}\n");
+    fclose(trace_file);
+    trace_file = NULL;
+}
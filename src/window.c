@@ -1,8 +1,27 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "window.h"
 #include "microui.h"
 #include "renderer.h"
+#include "trace.h"
 #include <SDL2/SDL.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HEADLESS_FRAMES 1000
+#define DEFAULT_WIDTH 1440
+#define DEFAULT_HEIGHT 900
+#define VERTEX_MIN_QUADS 8192
+#define DEFAULT_MODE "window"
+
+typedef struct {
+    char mode[32];
+    int width;
+    int height;
+} client_config_t;
 
 static char logbuf[64000];
 static int logbuf_updated = 0;
@@ -149,7 +168,8 @@ static void log_window(mu_Context *ctx) {
         mu_begin_panel(ctx, "Log Output");
         mu_Container *panel = mu_get_current_container(ctx);
         mu_layout_row(ctx, 1, (int[]) {-1}, -1);
-        mu_text(ctx, logbuf);
+        /* the log only grows by appending, so its lines can be referenced */
+        mu_text_ex(ctx, logbuf, MU_OPT_NOCOPY);
         mu_end_panel(ctx);
         if (logbuf_updated) {
             panel->scroll.y = panel->content_size.y;
@@ -260,34 +280,497 @@ static int text_height(mu_Font font) {
     return r_get_text_height();
 }
 
+typedef struct
+{
+    bool headless;
+    const char *mode;   // Renderer backend; overrides `client.mode` from the config
+    const char *config; // JSON config file to read `client.mode` from
+    int frames;         // 0 = run until the input source ends
+    int vertex_threads; // 0 = generate vertices on the main thread
+    int vertex_min_quads;
+    const char *replay;
+    const char *record;
+    const char *screenshot;
+    bool is_valid;
+} window_args_t;
+
+static window_args_t window_args_parse(int argc, char **argv) {
+    window_args_t args = {false, NULL, NULL, 0, 0, VERTEX_MIN_QUADS, NULL, NULL, NULL, true};
+    /* argv[1] is the `client` command itself */
+    for (int i = 2; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--headless") == 0) {
+            args.headless = true;
+        }
+        else if (strcmp(argv[i], "--mode") == 0 && value) {
+            args.mode = argv[++i];
+        }
+        else if (strcmp(argv[i], "--config") == 0 && value) {
+            args.config = argv[++i];
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && value) {
+            args.frames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--vertex-threads") == 0 && value) {
+            args.vertex_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--vertex-min-quads") == 0 && value) {
+            args.vertex_min_quads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && value) {
+            args.replay = argv[++i];
+        }
+        else if (strcmp(argv[i], "--record") == 0 && value) {
+            args.record = argv[++i];
+        }
+        else if (strcmp(argv[i], "--screenshot") == 0 && value) {
+            args.screenshot = argv[++i];
+        }
+        else {
+            fprintf(stderr, "Unknown client option '%s'\n", argv[i]);
+            args.is_valid = false;
+        }
+    }
+    return args;
+}
+
+static const char *skip_space(const char *p) {
+    while (*p && strchr(" \t\r\n", *p)) {
+        p++;
+    }
+    return p;
+}
+
+/* skips one JSON value: a string, number, literal, object or array */
+static const char *skip_value(const char *p) {
+    int depth = 0;
+    p = skip_space(p);
+    do {
+        if (*p == '"') {
+            for (p++; *p && *p != '"'; p++) {
+                if (*p == '\\' && p[1]) {
+                    p++;
+                }
+            }
+        }
+        else if (*p == '{' || *p == '[') {
+            depth++;
+        }
+        else if (*p == '}' || *p == ']') {
+            depth--;
+        }
+        else if (depth == 0) {
+            while (*p && !strchr(",}] \t\r\n", *p)) {
+                p++;
+            }
+            return p;
+        }
+        if (*p) {
+            p++;
+        }
+    } while (*p && depth > 0);
+    return p;
+}
+
+/* finds `key` among the members of the JSON object at `p`, without looking
+** into nested values; returns the start of its value, or NULL */
+static const char *config_member(const char *p, const char *key) {
+    p = p ? skip_space(p) : NULL;
+    if (!p || *p != '{') {
+        return NULL;
+    }
+    for (p++;; p++) {
+        p = skip_space(p);
+        if (*p != '"') {
+            return NULL;
+        }
+        const char *name = p + 1;
+        p = skip_value(p);
+        size_t len = p - name - 1;
+        p = skip_space(p);
+        if (*p != ':') {
+            return NULL;
+        }
+        p = skip_space(p + 1);
+        if (len == strlen(key) && !strncmp(name, key, len)) {
+            return p;
+        }
+        p = skip_space(skip_value(p));
+        if (*p != ',') {
+            return NULL;
+        }
+    }
+}
+
+/* reads an integer member, keeping `*value` when it is missing; returns 0
+** unless the number is outside [min, max] */
+static int config_int(const char *object, const char *key, int *value, int min, int max) {
+    const char *p = config_member(object, key);
+    char *end;
+    long n = p ? strtol(p, &end, 10) : 0;
+    if (!p || end == p) {
+        return 0;
+    }
+    if (n < min || n > max) {
+        fprintf(stderr, "Config: %s %ld is outside %d..%d\n", key, n, min, max);
+        return -1;
+    }
+    *value = n;
+    return 0;
+}
+
+/* reads the `client` settings of a JSON config over the defaults in `config`;
+** returns 0 on success */
+static int config_client(const char *path, client_config_t *config) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Cannot open config file %s\n", path);
+        return -1;
+    }
+    char text[8192];
+    size_t n = fread(text, 1, sizeof(text) - 1, fp);
+    fclose(fp);
+    text[n] = '\0';
+
+    const char *client = config_member(text, "client");
+    const char *p = config_member(client, "mode");
+    const char *end = p && *p == '"' ? strchr(p + 1, '"') : NULL;
+    if (end && (size_t) (end - p - 1) < sizeof(config->mode)) {
+        memcpy(config->mode, p + 1, end - p - 1);
+        config->mode[end - p - 1] = '\0';
+    }
+    /* the ranges of the schema */
+    if (config_int(client, "width", &config->width, 320, 7680) != 0 ||
+        config_int(client, "height", &config->height, 240, 4320) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/*============================================================================
+** input recording / replay
+**============================================================================*/
+
+/* events are recorded one per line as `<frame> <event> <args>`, where frame is
+** the number of frames processed before the event arrived; buttons and keys are
+** stored as MU_MOUSE_... / MU_KEY_... values so replays don't depend on SDL */
+
+static FILE *record_fp;
+
+static void record_input(mu_Context *ctx, const char *fmt, int a, int b, int c) {
+    if (record_fp) {
+        fprintf(record_fp, "%d ", ctx->frame);
+        fprintf(record_fp, fmt, a, b, c);
+        fputc('\n', record_fp);
+    }
+}
+
+static void record_text(mu_Context *ctx, const char *text) {
+    if (record_fp) {
+        fprintf(record_fp, "%d text %s\n", ctx->frame, text);
+    }
+}
+
+typedef struct
+{
+    FILE *fp;
+    char line[128];
+    bool pending; /* `line` holds an event for a later frame */
+} replay_t;
+
+/* applies the replay events recorded for `frame`; returns 0 once the file is
+** exhausted */
+static int replay_input(mu_Context *ctx, replay_t *replay, int frame) {
+    for (;;) {
+        int at, a = 0, b = 0, c = 0, n = 0;
+        char event[16];
+        char *line = replay->line;
+        if (!replay->pending && !fgets(line, sizeof(replay->line), replay->fp)) {
+            return 0;
+        }
+        replay->pending = false;
+        if (sscanf(line, "%d %15s %n", &at, event, &n) < 2) {
+            continue;
+        }
+        if (at > frame) {
+            replay->pending = true;
+            return 1;
+        }
+        sscanf(line + n, "%d %d %d", &a, &b, &c);
+        if (strcmp(event, "move") == 0) {
+            mu_input_mousemove(ctx, a, b);
+        }
+        else if (strcmp(event, "down") == 0) {
+            mu_input_mousedown(ctx, a, b, c);
+        }
+        else if (strcmp(event, "up") == 0) {
+            mu_input_mouseup(ctx, a, b, c);
+        }
+        else if (strcmp(event, "scroll") == 0) {
+            mu_input_scroll(ctx, a, b);
+        }
+        else if (strcmp(event, "keydown") == 0) {
+            mu_input_keydown(ctx, a);
+        }
+        else if (strcmp(event, "keyup") == 0) {
+            mu_input_keyup(ctx, a);
+        }
+        else if (strcmp(event, "text") == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            mu_input_text(ctx, line + n);
+        }
+    }
+}
+
+static int triangle(int t, int period) {
+    t %= 2 * period;
+    return t < period ? t : 2 * period - t;
+}
+
+/* deterministic input that sweeps the mouse over the screen, scrolls and
+** clicks inside window bodies (never on title bars, so windows stay open) */
+static void synthetic_input(mu_Context *ctx, renderer_t *r, int frame) {
+    int x = triangle(frame * 7, r->width - 1);
+    int y = triangle(frame * 5, r->height - 1);
+    mu_input_mousemove(ctx, x, y);
+
+    if (frame % 8 == 0) {
+        mu_input_scroll(ctx, 0, (frame / 8) % 2 ? 30 : -30);
+    }
+    if (ctx->mouse_down) {
+        mu_input_mouseup(ctx, x, y, MU_MOUSE_LEFT);
+    }
+    else if (frame % 30 == 0) {
+        const mu_Container *root = ctx->hover_root;
+        if (root && y - root->rect.y > ctx->style->title_height) {
+            mu_input_mousedown(ctx, x, y, MU_MOUSE_LEFT);
+        }
+    }
+}
+
+/*============================================================================
+** headless client
+**============================================================================*/
+
+enum
+{
+    PHASE_INPUT,
+    PHASE_PROCESS,
+    PHASE_COMMANDS,
+    PHASE_MAX
+};
+
+static const char *phase_names[PHASE_MAX] = {"input", "process_frame", "commands"};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void count_commands(mu_Context *ctx, long *counts) {
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        counts[cmd->type]++;
+    }
+}
+
+/* saves the last frame as a PPM image; backends that keep no pixels hand the
+** frame to a software instance */
+static int write_screenshot(renderer_t *r, mu_Context *ctx, const char *path) {
+    if (r_screenshot(r, path) == 0) {
+        return 0;
+    }
+    renderer_t *sr = r_create("software", r->width, r->height);
+    if (!sr) {
+        return -1;
+    }
+    r_clear(sr, mu_color(bg[0], bg[1], bg[2], 255));
+    r_render(sr, ctx);
+    int res = r_screenshot(sr, path);
+    r_destroy(sr);
+    return res;
+}
+
+static int window_run_headless(mu_Context *ctx, renderer_t *r, const window_args_t *args) {
+    replay_t replay = {NULL};
+    if (args->replay && !(replay.fp = fopen(args->replay, "r"))) {
+        fprintf(stderr, "Headless: cannot open replay file %s\n", args->replay);
+        return 1;
+    }
+
+    int limit = args->frames > 0 ? args->frames : (replay.fp ? 0 : HEADLESS_FRAMES);
+    double phase_ns[PHASE_MAX] = {0}, phase_max[PHASE_MAX] = {0};
+    long counts[MU_COMMAND_MAX] = {0};
+    int frame = 0;
+
+    double start = now_ns();
+    while (!limit || frame < limit) {
+        double t[PHASE_MAX + 1];
+        trace_begin("frame");
+
+        t[0] = now_ns();
+        trace_begin("input");
+        if (replay.fp) {
+            if (!replay_input(ctx, &replay, frame)) {
+                trace_end("input");
+                trace_end("frame");
+                break;
+            }
+        }
+        else {
+            synthetic_input(ctx, r, frame);
+        }
+        trace_end("input");
+
+        t[1] = now_ns();
+        trace_begin("process_frame");
+        process_frame(ctx);
+        trace_end("process_frame");
+
+        t[2] = now_ns();
+        trace_begin("commands");
+        r_clear(r, mu_color(bg[0], bg[1], bg[2], 255));
+        r_render(r, ctx);
+        r_present(r);
+        trace_end("commands");
+        t[3] = now_ns();
+        count_commands(ctx, counts);
+
+        for (int i = 0; i < PHASE_MAX; i++) {
+            phase_ns[i] += t[i + 1] - t[i];
+            phase_max[i] = mu_max(phase_max[i], t[i + 1] - t[i]);
+        }
+        frame++;
+        trace_end("frame");
+    }
+    double elapsed = now_ns() - start;
+
+    if (replay.fp) {
+        fclose(replay.fp);
+    }
+    if (frame == 0) {
+        printf("Headless: no frames processed\n");
+        return 1;
+    }
+
+    printf(
+        "Headless: %d frames in %.1f ms (%.1f fps, %s renderer)\n",
+        frame,
+        elapsed / 1e6,
+        frame * 1e9 / elapsed,
+        r->backend->name
+    );
+    printf("  %-14s %10s %10s %7s\n", "phase", "avg us", "max us", "share");
+    for (int i = 0; i < PHASE_MAX; i++) {
+        printf(
+            "  %-14s %10.2f %10.2f %6.1f%%\n",
+            phase_names[i],
+            phase_ns[i] / frame / 1e3,
+            phase_max[i] / 1e3,
+            phase_ns[i] * 100 / elapsed
+        );
+    }
+    printf(
+        "  commands/frame: %.1f rect, %.1f frame, %.1f text, %.1f icon, %.1f columns, %.1f clip\n",
+        (double) counts[MU_COMMAND_RECT] / frame,
+        (double) counts[MU_COMMAND_FRAME] / frame,
+        (double) counts[MU_COMMAND_TEXT] / frame,
+        (double) counts[MU_COMMAND_ICON] / frame,
+        (double) counts[MU_COMMAND_COLUMNS] / frame,
+        (double) counts[MU_COMMAND_CLIP] / frame
+    );
+
+    if (args->screenshot && write_screenshot(r, ctx, args->screenshot) != 0) {
+        fprintf(stderr, "Headless: cannot write screenshot %s\n", args->screenshot);
+        return 1;
+    }
+    return 0;
+}
+
 int window_command_run(int argc, char **argv, char **envp) {
-    /* init SDL and renderer */
-    SDL_Init(SDL_INIT_EVERYTHING);
-    r_init();
+    window_args_t args = window_args_parse(argc, argv);
+    if (!args.is_valid) {
+        return 1;
+    }
+
+    /* pick the backend: --mode, then `client.mode` from the config */
+    client_config_t config = {DEFAULT_MODE, DEFAULT_WIDTH, DEFAULT_HEIGHT};
+    if (args.config && config_client(args.config, &config) != 0) {
+        return 1;
+    }
+    const char *mode = args.mode ? args.mode : config.mode;
+    const renderer_backend_t *backend = r_find_backend(mode);
+    if (!backend) {
+        fprintf(stderr, "Unknown client mode '%s'\n", mode);
+        return 1;
+    }
+    /* windowless backends always run headless; headless runs of a windowed
+    ** mode measure the UI alone through the null backend */
+    if (!backend->windowed) {
+        args.headless = true;
+    }
+    else if (args.headless) {
+        backend = r_find_backend("null");
+    }
 
     /* init microui */
     mu_Context *ctx = malloc(sizeof(mu_Context));
     mu_init(ctx);
     ctx->text_width = text_width;
     ctx->text_height = text_height;
+    ctx->frame_commands = 1;
+    ctx->cull_occluded = 1;
+
+    if (args.headless) {
+        renderer_t *r = r_create(backend->name, config.width, config.height);
+        int res = r ? window_run_headless(ctx, r, &args) : 1;
+        r_destroy(r);
+        free(ctx);
+        return res;
+    }
+
+    if (args.record && !(record_fp = fopen(args.record, "w"))) {
+        fprintf(stderr, "Cannot open record file %s\n", args.record);
+        free(ctx);
+        return 1;
+    }
+
+    /* init SDL and renderer */
+    SDL_Init(SDL_INIT_EVERYTHING);
+    renderer_t *r = r_create(backend->name, config.width, config.height);
+    if (!r) {
+        free(ctx);
+        return 1;
+    }
+    r_set_vertex_threads(r, args.vertex_threads, args.vertex_min_quads);
 
     /* main loop */
-    for (;;) {
+    for (int frames = 0; !args.frames || frames < args.frames; frames++) {
+        trace_begin("frame");
+
         /* handle SDL events */
         SDL_Event e;
+        trace_begin("poll_events");
         while (SDL_PollEvent(&e)) {
             switch (e.type) {
             case SDL_QUIT:
+                if (record_fp) {
+                    fclose(record_fp);
+                }
                 exit(EXIT_SUCCESS);
                 break;
             case SDL_MOUSEMOTION:
                 mu_input_mousemove(ctx, e.motion.x, e.motion.y);
+                record_input(ctx, "move %d %d", e.motion.x, e.motion.y, 0);
                 break;
             case SDL_MOUSEWHEEL:
                 mu_input_scroll(ctx, 0, e.wheel.y * -30);
+                record_input(ctx, "scroll %d %d", 0, e.wheel.y * -30, 0);
                 break;
             case SDL_TEXTINPUT:
                 mu_input_text(ctx, e.text.text);
+                record_text(ctx, e.text.text);
                 break;
 
             case SDL_MOUSEBUTTONDOWN:
@@ -295,9 +778,11 @@ int window_command_run(int argc, char **argv, char **envp) {
                 int b = button_map[e.button.button & 0xff];
                 if (b && e.type == SDL_MOUSEBUTTONDOWN) {
                     mu_input_mousedown(ctx, e.button.x, e.button.y, b);
+                    record_input(ctx, "down %d %d %d", e.button.x, e.button.y, b);
                 }
                 if (b && e.type == SDL_MOUSEBUTTONUP) {
                     mu_input_mouseup(ctx, e.button.x, e.button.y, b);
+                    record_input(ctx, "up %d %d %d", e.button.x, e.button.y, b);
                 }
                 break;
             }
@@ -307,39 +792,41 @@ int window_command_run(int argc, char **argv, char **envp) {
                 int c = key_map[e.key.keysym.sym & 0xff];
                 if (c && e.type == SDL_KEYDOWN) {
                     mu_input_keydown(ctx, c);
+                    record_input(ctx, "keydown %d", c, 0, 0);
                 }
                 if (c && e.type == SDL_KEYUP) {
                     mu_input_keyup(ctx, c);
+                    record_input(ctx, "keyup %d", c, 0, 0);
                 }
                 break;
             }
             }
         }
+        trace_end("poll_events");
 
         /* process frame */
+        trace_begin("process_frame");
         process_frame(ctx);
+        trace_end("process_frame");
 
         /* render */
-        r_clear(mu_color(bg[0], bg[1], bg[2], 255));
-        mu_Command *cmd = NULL;
-        while (mu_next_command(ctx, &cmd)) {
-            switch (cmd->type) {
-            case MU_COMMAND_TEXT:
-                r_draw_text(cmd->text.str, cmd->text.pos, cmd->text.color);
-                break;
-            case MU_COMMAND_RECT:
-                r_draw_rect(cmd->rect.rect, cmd->rect.color);
-                break;
-            case MU_COMMAND_ICON:
-                r_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color);
-                break;
-            case MU_COMMAND_CLIP:
-                r_set_clip_rect(cmd->clip.rect);
-                break;
-            }
-        }
-        r_present();
+        trace_begin("r_clear");
+        r_clear(r, mu_color(bg[0], bg[1], bg[2], 255));
+        trace_end("r_clear");
+        trace_begin("commands");
+        r_render(r, ctx);
+        trace_end("commands");
+        trace_begin("r_present");
+        r_present(r);
+        trace_end("r_present");
+
+        trace_end("frame");
     }
 
+    if (record_fp) {
+        fclose(record_fp);
+    }
+    r_destroy(r);
+    free(ctx);
     return 0;
 }
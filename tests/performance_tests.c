@@ -1,6 +1,1340 @@
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "batch.h"
+#include "glyph_atlas.h"
+#include "microui.h"
+#include "soft_renderer.h"
+
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define MAX_SCENARIOS 64
+#define DEFAULT_SAMPLES 15
+#define DEFAULT_SAMPLE_NS 20000000.0 // Aim for ~20ms of work per sample
+#define QUICK_SAMPLE_NS 2000000.0
+#define DEFAULT_THRESHOLD 5.0 // Percent slowdown tolerated regardless of noise
+#define NOISE_SIGMAS 3.0      // Deltas inside this many combined sigmas are noise
+#define MAD_TO_SIGMA 1.4826   // Scales a median absolute deviation to a std deviation
+
+// Hardware counters sampled around each scenario when --counters is given
+enum
+{
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_MAX
+};
+
+static const char *counter_names[COUNTER_MAX] = {
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses",
+};
+
+// A benchmark scenario runs one iteration (typically one UI frame) per call.
+// `run` returns the number of work items processed, reported per second in
+// `unit`s, or 0 when throughput is not meaningful for the scenario.
+typedef struct
+{
+    const char *name;
+    const char *unit;
+    void (*setup)(void);
+    long (*run)(void);
+    void (*teardown)(void);
+} scenario_t;
+
+typedef struct
+{
+    const scenario_t *scenario;
+    long iterations; // Iterations per sample
+    int samples;
+    double median_ns; // All timings are per iteration
+    double mean_ns;
+    double min_ns;
+    double max_ns;
+    double stddev_ns;
+    double mad_ns;
+    double items;                 // Work items per iteration
+    double counters[COUNTER_MAX]; // Per iteration; negative when not measured
+} result_t;
+
+typedef struct
+{
+    char name[64];
+    double median_ns;
+    double mad_ns;
+} baseline_entry_t;
+
+typedef struct
+{
+    const char *json_path;
+    const char *baseline_path;
+    const char *filter;
+    double threshold;
+    double sample_ns;
+    int samples;
+    int counters;
+} options_t;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*============================================================================
+** microui fixtures
+**============================================================================*/
+
+static mu_Context *ui;
+static int ui_frame;
+static char ui_log[32768];
+static float ui_sliders[8] = {10, 20, 30, 40, 50, 60, 70, 80};
+static int ui_checks[8] = {1, 0, 1, 0, 1, 0, 1, 0};
+
+// Fixed-advance metrics keep the fixtures independent of any renderer
+static int text_width(mu_Font font, const char *text, int len) {
+    (void) font;
+    if (len == -1) {
+        len = strlen(text);
+    }
+    return len * 7;
+}
+
+static int text_height(mu_Font font) {
+    (void) font;
+    return 18;
+}
+
+static void ui_setup(void) {
+    ui = malloc(sizeof(mu_Context));
+    mu_init(ui);
+    ui->text_width = text_width;
+    ui->text_height = text_height;
+    ui_frame = 0;
+
+    ui_log[0] = '\0';
+    for (int i = 0; strlen(ui_log) + 80 < sizeof(ui_log); i++) {
+        char line[80];
+        snprintf(line, sizeof(line), "%05d: the quick brown fox jumps over the lazy dog\n", i);
+        strcat(ui_log, line);
+    }
+}
+
+static void ui_teardown(void) {
+    free(ui);
+    ui = NULL;
+}
+
+// Sweep the mouse across the screen so hover state changes every frame
+static void ui_input(void) {
+    int t = ui_frame++;
+    mu_input_mousemove(ui, (t * 7) % 800, (t * 3) % 600);
+}
+
+static long count_commands(void) {
+    long n = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ui, &cmd)) {
+        n++;
+    }
+    return n;
+}
+
+static void demo_controls(mu_Context *ctx, int index) {
+    char buf[32];
+    mu_push_id(ctx, &index, sizeof(index));
+    if (mu_header_ex(ctx, "Controls", MU_OPT_EXPANDED)) {
+        mu_layout_row(ctx, 3, (int[]) {86, -110, -1}, 0);
+        for (int i = 0; i < 4; i++) {
+            snprintf(buf, sizeof(buf), "Button %d", i);
+            mu_label(ctx, "Action:");
+            mu_button(ctx, buf);
+            mu_checkbox(ctx, "Check", &ui_checks[(index + i) % 8]);
+        }
+        mu_layout_row(ctx, 2, (int[]) {46, -1}, 0);
+        for (int i = 0; i < 4; i++) {
+            mu_label(ctx, "Value:");
+            mu_slider(ctx, &ui_sliders[(index + i) % 8], 0, 100);
+        }
+    }
+    if (mu_header_ex(ctx, "Tree", MU_OPT_EXPANDED)) {
+        if (mu_begin_treenode_ex(ctx, "Node", MU_OPT_EXPANDED)) {
+            mu_text(
+                ctx,
+                "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Maecenas "
+                "lacinia, sem eu lacinia molestie, mi risus faucibus ipsum."
+            );
+            mu_end_treenode(ctx);
+        }
+    }
+    mu_pop_id(ctx);
+}
+
+static long run_frame_demo(void) {
+    ui_input();
+    mu_begin(ui);
+    if (mu_begin_window(ui, "Demo", mu_rect(40, 40, 300, 450))) {
+        demo_controls(ui, 0);
+        mu_end_window(ui);
+    }
+    if (mu_begin_window(ui, "Log", mu_rect(350, 40, 300, 200))) {
+        mu_layout_row(ui, 1, (int[]) {-1}, -1);
+        mu_begin_panel(ui, "Output");
+        mu_layout_row(ui, 1, (int[]) {-1}, -1);
+        mu_text(ui, "Pressed button 1\nPressed button 2\nPressed button 3");
+        mu_end_panel(ui);
+        mu_end_window(ui);
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+// A toolbar-like grid of buttons with the same literal labels every frame,
+// from strings, from labels interned once, or in a cached region (with the
+// mouse parked outside the window, as hovering a button rebuilds it)
+static const char *toolbar_names[16] = {
+    "New",  "Open",   "Save", "Save As", "Close", "Undo",   "Redo",  "Cut",
+    "Copy", "Paste",  "Find", "Replace", "Zoom",  "Rotate", "Print", "Settings",
+};
+static mu_Label toolbar_labels[16];
+
+enum
+{
+    TOOLBAR_STRINGS,
+    TOOLBAR_INTERNED,
+    TOOLBAR_CACHED
+};
+
+static long frame_toolbar(int mode) {
+    int cached = mode == TOOLBAR_CACHED;
+    ui_input();
+    if (cached) {
+        mu_input_mousemove(ui, 900, 700);
+    }
+    mu_begin(ui);
+    if (mu_begin_window(ui, "Toolbar", mu_rect(0, 0, 800, 600))) {
+        mu_layout_row(ui, 8, (int[]) {96, 96, 96, 96, 96, 96, 96, -1}, 0);
+        if (!cached || mu_begin_cached(ui, mu_get_literal_id(ui, "Tools"), 0)) {
+            for (int row = 0; row < 16; row++) {
+                mu_push_id(ui, &row, sizeof(row));
+                for (int i = 0; i < 16; i++) {
+                    if (mode == TOOLBAR_INTERNED) {
+                        mu_button_l(ui, &toolbar_labels[i], 0, MU_OPT_ALIGNCENTER);
+                    }
+                    else {
+                        mu_button(ui, toolbar_names[i]);
+                    }
+                }
+                mu_pop_id(ui);
+            }
+        }
+        if (cached) {
+            mu_end_cached(ui);
+        }
+        mu_end_window(ui);
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+static void toolbar_setup(void) {
+    ui_setup();
+    for (int i = 0; i < 16; i++) {
+        toolbar_labels[i] = mu_intern_label(toolbar_names[i]);
+    }
+}
+
+// The same toolbar with each button's frame drawn as one command
+static void toolbar_frames_setup(void) {
+    toolbar_setup();
+    ui->frame_commands = 1;
+}
+
+static long run_frame_toolbar(void) {
+    return frame_toolbar(TOOLBAR_STRINGS);
+}
+
+static long run_frame_toolbar_interned(void) {
+    return frame_toolbar(TOOLBAR_INTERNED);
+}
+
+static long run_frame_toolbar_cached(void) {
+    return frame_toolbar(TOOLBAR_CACHED);
+}
+
+static long frame_text(int opt) {
+    ui_input();
+    mu_begin(ui);
+    if (mu_begin_window(ui, "Log", mu_rect(0, 0, 800, 600))) {
+        mu_layout_row(ui, 1, (int[]) {-1}, -1);
+        mu_begin_panel(ui, "Output");
+        mu_layout_row(ui, 1, (int[]) {-1}, -1);
+        mu_text_ex(ui, ui_log, opt);
+        mu_end_panel(ui);
+        mu_end_window(ui);
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+static long run_frame_text_heavy(void) {
+    return frame_text(0);
+}
+
+// The same log referenced in place instead of copied into the command list
+static long run_frame_text_nocopy(void) {
+    return frame_text(MU_OPT_NOCOPY);
+}
+
+// Wheel scrolling through the log, rebuilding the panel every frame or
+// replaying its content from the last one
+static long frame_scroll(int retained) {
+    int t = ui_frame++;
+    mu_input_mousemove(ui, 400, 300);
+    mu_input_scroll(ui, 0, t % 40 < 20 ? 30 : -30);
+    mu_begin(ui);
+    if (mu_begin_window(ui, "Log", mu_rect(0, 0, 800, 600))) {
+        int active = MU_RES_ACTIVE;
+        mu_layout_row(ui, 1, (int[]) {-1}, -1);
+        if (retained) {
+            active = mu_begin_scroll_panel(ui, "Output", 0, 0);
+        }
+        else {
+            mu_begin_panel(ui, "Output");
+        }
+        if (active) {
+            mu_layout_row(ui, 1, (int[]) {-1}, -1);
+            mu_text(ui, ui_log);
+        }
+        mu_end_panel(ui);
+        mu_end_window(ui);
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+static long run_frame_scroll(void) {
+    return frame_scroll(0);
+}
+
+static long run_frame_scroll_retained(void) {
+    return frame_scroll(1);
+}
+
+// Wheel scrolling through a table of a million rows, of which only those in
+// view are laid out
+static const int table_widths[3] = {80, 200, -1};
+static const char *table_titles[3] = {"Id", "Name", "Value"};
+
+static void table_row(mu_Context *ctx, int row, void *udata) {
+    char buf[32];
+    (void) udata;
+    snprintf(buf, sizeof(buf), "%d", row);
+    mu_label(ctx, buf);
+    mu_label(ctx, toolbar_names[row % 16]);
+    snprintf(buf, sizeof(buf), "%.3f", row * 0.001);
+    mu_label(ctx, buf);
+}
+
+static long run_frame_table(void) {
+    static mu_Table table = {3, table_widths, table_titles, 1000000, 20, NULL, 0, table_row, NULL};
+    int t = ui_frame++;
+    mu_input_mousemove(ui, 400, 300);
+    mu_input_scroll(ui, 0, t % 200 < 100 ? 240 : -240);
+    mu_begin(ui);
+    if (mu_begin_window(ui, "Table", mu_rect(0, 0, 800, 600))) {
+        mu_layout_row(ui, 1, (int[]) {-1}, -1);
+        mu_begin_table(ui, "Rows", &table, 0);
+        mu_end_table(ui);
+        mu_end_window(ui);
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+// A million samples of telemetry, streamed in at a thousand per frame and
+// plotted as one span per pixel column: scanning every sample each frame,
+// or looking their blocks up in the series' pyramid
+#define PLOT_WINDOW (1 << 20)
+
+static mu_Plot plot_series;
+
+static void plot_append(int n) {
+    float chunk[1024];
+    for (int i = 0; i < n; i++) {
+        unsigned t = ui_frame * 1024 + i;
+        /* a triangle wave with some noise on it */
+        chunk[i] = ((int) (t % 4000 > 2000 ? 4000 - t % 4000 : t % 4000) - 1000) / 1250.f +
+                   ((int) (t * 7919 % 101) - 50) / 500.f;
+    }
+    mu_plot_append(&plot_series, chunk, n);
+}
+
+static void plot_setup(void) {
+    ui_setup();
+    float *samples = malloc(PLOT_WINDOW * 2 * sizeof(float));
+    float *pyramid = malloc(PLOT_WINDOW * sizeof(float));
+    mu_plot_init(&plot_series, samples, pyramid, PLOT_WINDOW * 2);
+    for (ui_frame = 0; ui_frame < PLOT_WINDOW / 1024; ui_frame++) {
+        plot_append(1024);
+    }
+}
+
+static void plot_teardown(void) {
+    free(plot_series.samples);
+    free(plot_series.pyramid);
+    ui_teardown();
+}
+
+static long frame_plot(int pyramid) {
+    const mu_Plot *p = &plot_series;
+    plot_append(1000);
+    ui_frame++;
+    mu_begin(ui);
+    if (mu_begin_window(ui, "Telemetry", mu_rect(0, 0, 800, 600))) {
+        mu_layout_row(ui, 1, (int[]) {-1}, -1);
+        if (pyramid) {
+            mu_plot_series(ui, p, PLOT_WINDOW, -1, 1);
+        }
+        else {
+            mu_plot(ui, p->samples + p->count - PLOT_WINDOW, PLOT_WINDOW, -1, 1);
+        }
+        mu_end_window(ui);
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+static long run_frame_plot_scan(void) {
+    return frame_plot(0);
+}
+
+static long run_frame_plot_series(void) {
+    return frame_plot(1);
+}
+
+static long run_frame_many_windows(void) {
+    ui_input();
+    mu_begin(ui);
+    for (int i = 0; i < 24; i++) {
+        char title[32];
+        snprintf(title, sizeof(title), "Window %d", i);
+        if (mu_begin_window(ui, title, mu_rect(20 * i, 15 * i, 260, 240))) {
+            demo_controls(ui, i);
+            mu_end_window(ui);
+        }
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+// The same windows with the command list optimized in mu_end()
+static void optimize_setup(void) {
+    ui_setup();
+    ui->optimize_commands = 1;
+}
+
+// ...and with the commands hidden under the windows above dropped
+static void cull_setup(void) {
+    ui_setup();
+    ui->cull_occluded = 1;
+}
+
+static void commands_setup(void) {
+    ui_setup();
+    run_frame_many_windows();
+}
+
+static long run_commands_iterate(void) {
+    long n = 0, sum = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ui, &cmd)) {
+        sum += cmd->type;
+        n++;
+    }
+    return sum > 0 ? n : 0;
+}
+
+// Text metrics for every line of the log and a set of short labels, per
+// kernel set; most real strings are labels, so both lengths are covered
+static const char *text_labels[] = {
+    "OK", "Cancel", "Apply", "Window 12", "Slider", "Checkbox 3", "Background", "Header",
+};
+
+static void text_width_setup(ga_isa_t isa) {
+    ui_setup();
+    ga_set_isa(isa);
+}
+
+static void text_width_scalar_setup(void) {
+    text_width_setup(GA_ISA_SCALAR);
+}
+
+static void text_width_auto_setup(void) {
+    text_width_setup(GA_ISA_AUTO);
+}
+
+static void text_width_teardown(void) {
+    ga_set_isa(GA_ISA_AUTO);
+    ui_teardown();
+}
+
+static long run_text_width(void) {
+    long bytes = 0, sum = 0;
+    for (const char *line = ui_log; *line;) {
+        int len = strcspn(line, "\n");
+        sum += ga_text_width(line, len);
+        bytes += len + 1;
+        line += len + 1;
+    }
+    for (int i = 0; i < 64; i++) {
+        const char *label = text_labels[i % 8];
+        sum += ga_text_width(label, -1);
+        bytes += strlen(label);
+    }
+    return sum > 0 ? bytes : 0;
+}
+
+// Software rasterization of a prebuilt frame, per kernel set
+static soft_renderer_t *raster;
+
+static void raster_setup(sr_isa_t isa, long (*frame)(void)) {
+    ui_setup();
+    frame();
+    raster = sr_create(800, 600);
+    sr_set_isa(raster, isa);
+}
+
+static void raster_windows_scalar_setup(void) {
+    raster_setup(SR_ISA_SCALAR, run_frame_many_windows);
+}
+
+static void raster_windows_setup(void) {
+    raster_setup(SR_ISA_AUTO, run_frame_many_windows);
+}
+
+static void raster_windows_culled_setup(void) {
+    raster_setup(SR_ISA_AUTO, run_frame_many_windows);
+    ui->cull_occluded = 1;
+    run_frame_many_windows();
+}
+
+static void raster_text_setup(void) {
+    raster_setup(SR_ISA_AUTO, run_frame_text_heavy);
+}
+
+// Vertex generation into the renderer's quad batch, without a GPU
+#define BATCH_QUADS 16384
+
+static batch_t vertex_batch;
+static batch_cache_t *vertex_cache;
+static batch_workers_t *vertex_workers;
+static long batched_quads;
+
+static void batch_discard(batch_t *b) {
+    batched_quads += b->quads;
+    b->quads = 0;
+}
+
+static void batch_setup(long (*frame)(void)) {
+    ui_setup();
+    frame();
+    batch_vertex_t *vertices = malloc(BATCH_QUADS * 4 * sizeof(batch_vertex_t));
+    batch_init(&vertex_batch, vertices, BATCH_QUADS, batch_discard);
+}
+
+static void batch_text_setup(void) {
+    batch_setup(run_frame_text_heavy);
+}
+
+static void batch_windows_setup(void) {
+    batch_setup(run_frame_many_windows);
+}
+
+static void batch_cached_setup(void) {
+    batch_setup(run_frame_many_windows);
+    vertex_cache = batch_cache_create();
+}
+
+static void batch_parallel_setup(void) {
+    batch_setup(run_frame_text_heavy);
+    vertex_workers = batch_workers_create(4, 0);
+}
+
+static void batch_teardown(void) {
+    batch_cache_destroy(vertex_cache);
+    vertex_cache = NULL;
+    batch_workers_destroy(vertex_workers);
+    vertex_workers = NULL;
+    free(vertex_batch.vertices);
+    ui_teardown();
+}
+
+static long run_batch(void) {
+    mu_Command *cmd = NULL;
+    batched_quads = 0;
+    batch_set_clip(&vertex_batch, mu_rect(0, 0, 0x1000000, 0x1000000));
+    while (mu_next_command(ui, &cmd)) {
+        switch (cmd->type) {
+        case MU_COMMAND_TEXT:
+            batch_draw_text(
+                &vertex_batch, mu_text_str(&cmd->text), cmd->text.len, cmd->text.pos, cmd->text.color
+            );
+            break;
+        case MU_COMMAND_RECT:
+            batch_draw_rect(&vertex_batch, cmd->rect.rect, cmd->rect.color);
+            break;
+        case MU_COMMAND_ICON:
+            batch_draw_icon(&vertex_batch, cmd->icon.id, cmd->icon.rect, cmd->icon.color);
+            break;
+        case MU_COMMAND_COLUMNS:
+            batch_draw_columns(
+                &vertex_batch, cmd->columns.rect, cmd->columns.spans, cmd->columns.color
+            );
+            break;
+        case MU_COMMAND_FRAME:
+            batch_draw_frame(
+                &vertex_batch,
+                cmd->frame.rect,
+                cmd->frame.color,
+                cmd->frame.border,
+                cmd->frame.border_width
+            );
+            break;
+        case MU_COMMAND_CLIP:
+            batch_set_clip(&vertex_batch, cmd->clip.rect);
+            break;
+        }
+    }
+    batch_discard(&vertex_batch);
+    return batched_quads;
+}
+
+// Unchanged windows, so every container's vertices come from the cache
+static long run_batch_cached(void) {
+    batched_quads = 0;
+    batch_set_clip(&vertex_batch, mu_rect(0, 0, 0x1000000, 0x1000000));
+    batch_render(&vertex_batch, vertex_cache, ui);
+    batch_discard(&vertex_batch);
+    return batched_quads;
+}
+
+static long run_batch_parallel(void) {
+    batched_quads = 0;
+    batch_set_clip(&vertex_batch, mu_rect(0, 0, 0x1000000, 0x1000000));
+    batch_render_parallel(&vertex_batch, vertex_workers, ui);
+    batch_discard(&vertex_batch);
+    return batched_quads;
+}
+
+// A 4K surface covered by a grid of demo windows (MU_ROOTLIST_SIZE of them)
+static long run_frame_4k(void) {
+    mu_begin(ui);
+    for (int i = 0; i < MU_ROOTLIST_SIZE; i++) {
+        char title[32];
+        snprintf(title, sizeof(title), "Window %d", i);
+        if (mu_begin_window(ui, title, mu_rect(i % 8 * 480, i / 8 * 540, 480, 540))) {
+            demo_controls(ui, i);
+            mu_text(ui, ui_log + i * 512);
+            mu_end_window(ui);
+        }
+    }
+    mu_end(ui);
+    return count_commands();
+}
+
+static void raster_4k_setup(int threads) {
+    ui_setup();
+    run_frame_4k();
+    raster = sr_create(3840, 2160);
+    sr_set_threads(raster, threads);
+}
+
+static void raster_4k_direct_setup(void) {
+    raster_4k_setup(0);
+}
+
+static void raster_4k_t1_setup(void) {
+    raster_4k_setup(1);
+}
+
+static void raster_4k_t2_setup(void) {
+    raster_4k_setup(2);
+}
+
+static void raster_4k_t4_setup(void) {
+    raster_4k_setup(4);
+}
+
+static void raster_4k_t8_setup(void) {
+    raster_4k_setup(8);
+}
+
+static void raster_teardown(void) {
+    sr_destroy(raster);
+    raster = NULL;
+    ui_teardown();
+}
+
+static long run_raster(void) {
+    sr_clear(raster, mu_color(90, 95, 100, 255));
+    sr_render(raster, ui);
+    return count_commands();
+}
+
+static const scenario_t scenarios[] = {
+    {"frame_demo", "commands", ui_setup, run_frame_demo, ui_teardown},
+    {"frame_text_heavy", "commands", ui_setup, run_frame_text_heavy, ui_teardown},
+    {"frame_text_nocopy", "commands", ui_setup, run_frame_text_nocopy, ui_teardown},
+    {"frame_toolbar", "commands", toolbar_setup, run_frame_toolbar, ui_teardown},
+    {"frame_toolbar_interned", "commands", toolbar_setup, run_frame_toolbar_interned, ui_teardown},
+    {"frame_toolbar_frames", "commands", toolbar_frames_setup, run_frame_toolbar, ui_teardown},
+    {"frame_toolbar_cached", "commands", toolbar_setup, run_frame_toolbar_cached, ui_teardown},
+    {"frame_scroll", "commands", ui_setup, run_frame_scroll, ui_teardown},
+    {"frame_scroll_retained", "commands", ui_setup, run_frame_scroll_retained, ui_teardown},
+    {"frame_table", "commands", ui_setup, run_frame_table, ui_teardown},
+    {"frame_plot_scan", "commands", plot_setup, run_frame_plot_scan, plot_teardown},
+    {"frame_plot_series", "commands", plot_setup, run_frame_plot_series, plot_teardown},
+    {"frame_many_windows", "commands", ui_setup, run_frame_many_windows, ui_teardown},
+    {"frame_windows_optimized", "commands", optimize_setup, run_frame_many_windows, ui_teardown},
+    {"frame_windows_culled", "commands", cull_setup, run_frame_many_windows, ui_teardown},
+    {"commands_iterate", "commands", commands_setup, run_commands_iterate, ui_teardown},
+    {"batch_text_heavy", "quads", batch_text_setup, run_batch, batch_teardown},
+    {"batch_text_parallel", "quads", batch_parallel_setup, run_batch_parallel, batch_teardown},
+    {"batch_many_windows", "quads", batch_windows_setup, run_batch, batch_teardown},
+    {"batch_many_windows_cached", "quads", batch_cached_setup, run_batch_cached, batch_teardown},
+    {"text_width_scalar", "bytes", text_width_scalar_setup, run_text_width, text_width_teardown},
+    {"text_width", "bytes", text_width_auto_setup, run_text_width, text_width_teardown},
+    {"raster_windows_scalar", "commands", raster_windows_scalar_setup, run_raster, raster_teardown},
+    {"raster_windows", "commands", raster_windows_setup, run_raster, raster_teardown},
+    {"raster_windows_culled", "commands", raster_windows_culled_setup, run_raster, raster_teardown},
+    {"raster_text_heavy", "commands", raster_text_setup, run_raster, raster_teardown},
+    {"raster_4k", "commands", raster_4k_direct_setup, run_raster, raster_teardown},
+    {"raster_4k_tiled_t1", "commands", raster_4k_t1_setup, run_raster, raster_teardown},
+    {"raster_4k_tiled_t2", "commands", raster_4k_t2_setup, run_raster, raster_teardown},
+    {"raster_4k_tiled_t4", "commands", raster_4k_t4_setup, run_raster, raster_teardown},
+    {"raster_4k_tiled_t8", "commands", raster_4k_t8_setup, run_raster, raster_teardown},
+};
+
+/*============================================================================
+** hardware counters
+**============================================================================*/
+
+static int counter_fds[COUNTER_MAX] = {-1, -1, -1, -1, -1};
+
+#ifdef __linux__
+static int open_counter(unsigned type, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+// Opens whatever subset of counters the kernel allows; containers commonly
+// deny perf events entirely, in which case the benchmarks run without them
+static int counters_open(void) {
+    int opened = 0;
+#ifdef __linux__
+    static const struct
+    {
+        unsigned type;
+        unsigned long long config;
+    } events[COUNTER_MAX] = {
+        [COUNTER_CYCLES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        [COUNTER_INSTRUCTIONS] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        [COUNTER_L1D_MISSES] =
+            {PERF_TYPE_HW_CACHE,
+             PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        [COUNTER_LLC_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        [COUNTER_BRANCH_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+    int error = 0;
+    for (int i = 0; i < COUNTER_MAX; i++) {
+        counter_fds[i] = open_counter(events[i].type, events[i].config);
+        if (counter_fds[i] >= 0) {
+            opened++;
+        }
+        else if (!error) {
+            error = errno;
+        }
+    }
+    if (opened == 0) {
+        fprintf(
+            stderr,
+            "⚠️  Hardware counters unavailable (%s); check kernel.perf_event_paranoid or the "
+            "container's seccomp profile\n",
+            strerror(error)
+        );
+    }
+    else if (opened < COUNTER_MAX) {
+        fprintf(stderr, "⚠️  Only %d of %d hardware counters available\n", opened, COUNTER_MAX);
+    }
+#else
+    fprintf(stderr, "⚠️  Hardware counters are only supported on Linux\n");
+#endif
+    return opened;
+}
+
+static void counters_close(void) {
+    for (int i = 0; i < COUNTER_MAX; i++) {
+        if (counter_fds[i] >= 0) {
+            close(counter_fds[i]);
+            counter_fds[i] = -1;
+        }
+    }
+}
+
+static void counters_start(void) {
+#ifdef __linux__
+    for (int i = 0; i < COUNTER_MAX; i++) {
+        if (counter_fds[i] >= 0) {
+            ioctl(counter_fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+// Reads counters scaled for multiplexing and divided by `iterations`
+static void counters_stop(double *values, long iterations) {
+    for (int i = 0; i < COUNTER_MAX; i++) {
+        values[i] = -1;
+#ifdef __linux__
+        unsigned long long data[3]; // value, time enabled, time running
+        if (counter_fds[i] < 0) {
+            continue;
+        }
+        ioctl(counter_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter_fds[i], data, sizeof(data)) == sizeof(data) && data[2] > 0) {
+            values[i] = (double) data[0] * data[1] / data[2] / iterations;
+        }
+#endif
+    }
+}
+
+/*============================================================================
+** measurement
+**============================================================================*/
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, int n) {
+    qsort(values, n, sizeof(double), compare_doubles);
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+static result_t run_scenario(const scenario_t *s, const options_t *opts) {
+    result_t r;
+    double times[64];
+    double deviations[64];
+    memset(&r, 0, sizeof(r));
+    r.scenario = s;
+    r.samples = opts->samples;
+
+    if (s->setup) {
+        s->setup();
+    }
+
+    // Warm up and calibrate the iteration count to the requested sample time
+    long iterations = 1;
+    for (;;) {
+        double start = now_ns();
+        for (long i = 0; i < iterations; i++) {
+            s->run();
+        }
+        double elapsed = now_ns() - start;
+        if (elapsed >= opts->sample_ns / 4 || iterations >= (1L << 24)) {
+            iterations = mu_max(1, (long) (iterations * opts->sample_ns / mu_max(elapsed, 1)));
+            break;
+        }
+        iterations *= 4;
+    }
+    r.iterations = iterations;
+
+    long items = 0;
+    counters_start();
+    for (int i = 0; i < r.samples; i++) {
+        items = 0;
+        double start = now_ns();
+        for (long j = 0; j < iterations; j++) {
+            items += s->run();
+        }
+        times[i] = (now_ns() - start) / iterations;
+    }
+    counters_stop(r.counters, iterations * r.samples);
+    r.items = (double) items / iterations;
+
+    if (s->teardown) {
+        s->teardown();
+    }
+
+    double sum = 0, sq = 0;
+    r.min_ns = r.max_ns = times[0];
+    for (int i = 0; i < r.samples; i++) {
+        sum += times[i];
+        r.min_ns = mu_min(r.min_ns, times[i]);
+        r.max_ns = mu_max(r.max_ns, times[i]);
+    }
+    r.mean_ns = sum / r.samples;
+    for (int i = 0; i < r.samples; i++) {
+        sq += (times[i] - r.mean_ns) * (times[i] - r.mean_ns);
+    }
+    r.stddev_ns = r.samples > 1 ? sqrt(sq / (r.samples - 1)) : 0;
+    r.median_ns = median(times, r.samples);
+    for (int i = 0; i < r.samples; i++) {
+        deviations[i] = fabs(times[i] - r.median_ns);
+    }
+    r.mad_ns = median(deviations, r.samples);
+    return r;
+}
+
+static const char *format_ns(double ns, char *buf, size_t size) {
+    if (ns >= 1e9) {
+        snprintf(buf, size, "%.2f s", ns / 1e9);
+    }
+    else if (ns >= 1e6) {
+        snprintf(buf, size, "%.2f ms", ns / 1e6);
+    }
+    else if (ns >= 1e3) {
+        snprintf(buf, size, "%.2f us", ns / 1e3);
+    }
+    else {
+        snprintf(buf, size, "%.1f ns", ns);
+    }
+    return buf;
+}
+
+static void print_result(const result_t *r) {
+    char median_buf[32], mad_buf[32];
+    printf(
+        "  %-28s %12s  ±%-10s",
+        r->scenario->name,
+        format_ns(r->median_ns, median_buf, sizeof(median_buf)),
+        format_ns(r->mad_ns, mad_buf, sizeof(mad_buf))
+    );
+    if (r->items > 0 && r->median_ns > 0) {
+        printf("  %10.3g %s/s", r->items * 1e9 / r->median_ns, r->scenario->unit);
+    }
+    printf("\n");
+
+    // Counter figures are per iteration, i.e. per frame for the UI scenarios
+    int shown = 0;
+    for (int i = 0; i < COUNTER_MAX; i++) {
+        if (r->counters[i] >= 0) {
+            const char *sep = shown++ ? ", " : "    └ per frame: ";
+            printf("%s%.4g %s", sep, r->counters[i], counter_names[i]);
+        }
+    }
+    if (r->counters[COUNTER_CYCLES] > 0 && r->counters[COUNTER_INSTRUCTIONS] >= 0) {
+        printf(", %.2f IPC", r->counters[COUNTER_INSTRUCTIONS] / r->counters[COUNTER_CYCLES]);
+    }
+    if (shown) {
+        printf("\n");
+    }
+}
+
+/*============================================================================
+** JSON output
+**============================================================================*/
+
+static void json_string(FILE *fp, const char *str) {
+    fputc('"', fp);
+    for (const char *p = str; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(fp, "\\%c", *p);
+        }
+        else if ((unsigned char) *p < 0x20) {
+            fprintf(fp, "\\u%04x", (unsigned char) *p);
+        }
+        else {
+            fputc(*p, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+static void cpu_model(char *buf, size_t size) {
+    snprintf(buf, size, "unknown");
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    if (!fp) {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char *colon = strchr(line, ':');
+        if (strncmp(line, "model name", 10) == 0 && colon) {
+            colon += 2;
+            colon[strcspn(colon, "\n")] = '\0';
+            snprintf(buf, size, "%s", colon);
+            break;
+        }
+    }
+    fclose(fp);
+}
+
+static int write_json(const char *path, const result_t *results, int count) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "❌ Cannot write benchmark results to %s\n", path);
+        return -1;
+    }
+
+    struct utsname host;
+    char cpu[128], stamp[32];
+    time_t t = time(NULL);
+    uname(&host);
+    cpu_model(cpu, sizeof(cpu));
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+
+    fprintf(fp, "{\n  \"schema\": 1,\n  \"microui\": ");
+    json_string(fp, MU_VERSION);
+    fprintf(fp, ",\n  \"timestamp\": ");
+    json_string(fp, stamp);
+    fprintf(fp, ",\n  \"host\": {\n    \"hostname\": ");
+    json_string(fp, host.nodename);
+    fprintf(fp, ",\n    \"os\": ");
+    json_string(fp, host.sysname);
+    fprintf(fp, ",\n    \"release\": ");
+    json_string(fp, host.release);
+    fprintf(fp, ",\n    \"machine\": ");
+    json_string(fp, host.machine);
+    fprintf(fp, ",\n    \"cpu\": ");
+    json_string(fp, cpu);
+    fprintf(fp, ",\n    \"cpus\": %ld", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(fp, ",\n    \"compiler\": ");
+    json_string(fp, __VERSION__);
+#ifdef __OPTIMIZE__
+    fprintf(fp, ",\n    \"optimized\": true\n  },\n");
+#else
+    fprintf(fp, ",\n    \"optimized\": false\n  },\n");
+#endif
+
+    fprintf(fp, "  \"scenarios\": {\n");
+    for (int i = 0; i < count; i++) {
+        const result_t *r = &results[i];
+        fprintf(fp, "    ");
+        json_string(fp, r->scenario->name);
+        fprintf(
+            fp,
+            ": {\"iterations\": %ld, \"samples\": %d, \"median_ns\": %.1f, \"mean_ns\": %.1f, "
+            "\"min_ns\": %.1f, \"max_ns\": %.1f, \"stddev_ns\": %.1f, \"mad_ns\": %.1f, "
+            "\"items\": %.1f, \"unit\": ",
+            r->iterations,
+            r->samples,
+            r->median_ns,
+            r->mean_ns,
+            r->min_ns,
+            r->max_ns,
+            r->stddev_ns,
+            r->mad_ns,
+            r->items
+        );
+        json_string(fp, r->scenario->unit);
+        int shown = 0;
+        for (int j = 0; j < COUNTER_MAX; j++) {
+            if (r->counters[j] >= 0) {
+                const char *sep = shown++ ? ", " : ", \"counters\": {";
+                fprintf(fp, "%s\"%s\": %.1f", sep, counter_names[j], r->counters[j]);
+            }
+        }
+        fprintf(fp, "%s}%s\n", shown ? "}" : "", i + 1 < count ? "," : "");
+    }
+    fprintf(fp, "  }\n}\n");
+    fclose(fp);
+    return 0;
+}
+
+/*============================================================================
+** baseline comparison
+**============================================================================*/
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = malloc(size + 1);
+    if (buf && fread(buf, 1, size, fp) != (size_t) size) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) {
+        buf[size] = '\0';
+    }
+    fclose(fp);
+    return buf;
+}
+
+static const char *skip_ws(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == ',' || *p == ':') {
+        p++;
+    }
+    return p;
+}
+
+static const char *parse_key(const char *p, char *key, size_t size) {
+    size_t n = 0;
+    if (*p != '"') {
+        return NULL;
+    }
+    for (p++; *p && *p != '"'; p++) {
+        if (*p == '\\' && p[1]) {
+            p++;
+        }
+        if (n + 1 < size) {
+            key[n++] = *p;
+        }
+    }
+    key[n] = '\0';
+    return *p ? p + 1 : NULL;
+}
+
+// Reads the flat per-scenario objects written by `write_json`; anything it does
+// not understand ends the scan rather than failing the comparison outright
+static int load_baseline(const char *path, baseline_entry_t *entries, int max) {
+    char *json = read_file(path);
+    if (!json) {
+        return -1;
+    }
+    int count = 0;
+    const char *p = strstr(json, "\"scenarios\"");
+    p = p ? strchr(p, '{') : NULL;
+    while (p && count < max) {
+        baseline_entry_t *e = &entries[count];
+        p = skip_ws(p + 1);
+        if (*p != '"' || !(p = parse_key(p, e->name, sizeof(e->name)))) {
+            break;
+        }
+        p = skip_ws(p);
+        if (*p != '{') {
+            break;
+        }
+        e->median_ns = e->mad_ns = 0;
+        while (*p && *p != '}') {
+            char field[32];
+            p = skip_ws(p + 1);
+            if (!(p = parse_key(p, field, sizeof(field)))) {
+                break;
+            }
+            p = skip_ws(p);
+            if (strcmp(field, "median_ns") == 0) {
+                e->median_ns = strtod(p, NULL);
+            }
+            else if (strcmp(field, "mad_ns") == 0) {
+                e->mad_ns = strtod(p, NULL);
+            }
+            else if (*p == '{') {
+                // Nested objects (e.g. counters) are flat; skip them whole
+                p = strchr(p, '}');
+                if (!p) {
+                    break;
+                }
+                p++;
+            }
+            while (*p && *p != ',' && *p != '}') {
+                p++;
+            }
+        }
+        if (!p || *p != '}') {
+            break;
+        }
+        if (e->median_ns > 0) {
+            count++;
+        }
+    }
+    free(json);
+    return count;
+}
+
+// Returns the number of scenarios that regressed beyond both the fixed
+// threshold and the measurement noise of the two runs
+static int compare_baseline(const options_t *opts, const result_t *results, int count) {
+    baseline_entry_t baseline[MAX_SCENARIOS];
+    int n = load_baseline(opts->baseline_path, baseline, MAX_SCENARIOS);
+    if (n < 0) {
+        fprintf(stderr, "❌ Cannot read baseline %s\n", opts->baseline_path);
+        return -1;
+    }
+
+    int regressions = 0;
+    printf("\n📊 Comparison against %s (threshold %.1f%%)\n", opts->baseline_path, opts->threshold);
+    printf(
+        "  %-28s %12s %12s %9s %9s  %s\n",
+        "scenario",
+        "baseline",
+        "current",
+        "delta",
+        "noise",
+        "verdict"
+    );
+    for (int i = 0; i < count; i++) {
+        const result_t *r = &results[i];
+        const baseline_entry_t *b = NULL;
+        char base_buf[32], cur_buf[32];
+        for (int j = 0; j < n; j++) {
+            if (strcmp(baseline[j].name, r->scenario->name) == 0) {
+                b = &baseline[j];
+                break;
+            }
+        }
+        if (!b) {
+            printf(
+                "  %-28s %12s %12s %9s %9s  new\n",
+                r->scenario->name,
+                "-",
+                format_ns(r->median_ns, cur_buf, sizeof(cur_buf)),
+                "-",
+                "-"
+            );
+            continue;
+        }
+
+        double delta = (r->median_ns - b->median_ns) / b->median_ns * 100;
+        double base_noise = MAD_TO_SIGMA * b->mad_ns / b->median_ns;
+        double cur_noise = MAD_TO_SIGMA * r->mad_ns / r->median_ns;
+        double noise = NOISE_SIGMAS * sqrt(base_noise * base_noise + cur_noise * cur_noise) * 100;
+        double limit = mu_max(opts->threshold, noise);
+        const char *verdict = "ok";
+        if (delta > limit) {
+            verdict = "❌ regression";
+            regressions++;
+        }
+        else if (delta < -limit) {
+            verdict = "✅ improvement";
+        }
+        printf(
+            "  %-28s %12s %12s %+8.1f%% %8.1f%%  %s\n",
+            r->scenario->name,
+            format_ns(b->median_ns, base_buf, sizeof(base_buf)),
+            format_ns(r->median_ns, cur_buf, sizeof(cur_buf)),
+            delta,
+            noise,
+            verdict
+        );
+    }
+    return regressions;
+}
+
+/*============================================================================
+** main
+**============================================================================*/
+
+static void usage(const char *program) {
+    printf("Usage: %s [options]\n\n", program);
+    printf("Options:\n");
+    printf("  --json <file>        Write results as JSON\n");
+    printf("  --baseline <file>    Compare against a stored JSON baseline\n");
+    printf(
+        "  --threshold <pct>    Minimum slowdown treated as a regression (default %.0f)\n",
+        DEFAULT_THRESHOLD
+    );
+    printf("  --filter <text>      Only run scenarios whose name contains <text>\n");
+    printf("  --samples <n>        Samples per scenario (default %d)\n", DEFAULT_SAMPLES);
+    printf("  --quick              Shorter samples, for smoke testing\n");
+    printf("  --counters           Report hardware counters per iteration (Linux perf events)\n");
+}
 
 int main(int argc, char **argv, char **envp) {
-    printf("Performance tests are not implemented yet.\n");
+    options_t opts = {NULL, NULL, NULL, DEFAULT_THRESHOLD, DEFAULT_SAMPLE_NS, DEFAULT_SAMPLES, 0};
+    (void) envp;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--json") == 0 && value) {
+            opts.json_path = argv[++i];
+        }
+        else if (strcmp(arg, "--baseline") == 0 && value) {
+            opts.baseline_path = argv[++i];
+        }
+        else if (strcmp(arg, "--threshold") == 0 && value) {
+            opts.threshold = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(arg, "--filter") == 0 && value) {
+            opts.filter = argv[++i];
+        }
+        else if (strcmp(arg, "--samples") == 0 && value) {
+            int samples = atoi(argv[++i]);
+            opts.samples = mu_clamp(samples, 3, 64);
+        }
+        else if (strcmp(arg, "--quick") == 0) {
+            opts.sample_ns = QUICK_SAMPLE_NS;
+        }
+        else if (strcmp(arg, "--counters") == 0) {
+            opts.counters = 1;
+        }
+        else {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    result_t results[MAX_SCENARIOS];
+    int count = 0;
+    if (opts.counters) {
+        counters_open();
+    }
+    printf("⚡ microui %s benchmarks\n", MU_VERSION);
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (opts.filter && !strstr(scenarios[i].name, opts.filter)) {
+            continue;
+        }
+        results[count] = run_scenario(&scenarios[i], &opts);
+        print_result(&results[count]);
+        count++;
+    }
+    counters_close();
+
+    if (opts.json_path) {
+        if (write_json(opts.json_path, results, count) != 0) {
+            return 1;
+        }
+        printf("📝 Results written to %s\n", opts.json_path);
+    }
+
+    if (opts.baseline_path) {
+        int regressions = compare_baseline(&opts, results, count);
+        if (regressions < 0) {
+            return 1;
+        }
+        if (regressions > 0) {
+            printf("❌ %d scenario(s) regressed\n", regressions);
+            return 2;
+        }
+        printf("✅ No significant regressions\n");
+    }
+
     return 0;
 }
@@ -1,6 +1,1417 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "batch.h"
+#include "glyph_atlas.h"
+#include "microui.h"
+#include "renderer.h"
+#include "soft_renderer.h"
+
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static int checks;
+static int failures;
+
+#define check(x)                                                                                   \
+    do {                                                                                           \
+        checks++;                                                                                  \
+        if (!(x)) {                                                                                \
+            failures++;                                                                            \
+            fprintf(stderr, "❌ %s:%d: check '%s' failed\n", __FILE__, __LINE__, #x);             \
+        }                                                                                          \
+    } while (0)
+
+static int text_width(mu_Font font, const char *text, int len) {
+    (void) font;
+    if (len == -1) {
+        len = strlen(text);
+    }
+    return len * 7;
+}
+
+static int text_height(mu_Font font) {
+    (void) font;
+    return 18;
+}
+
+static mu_Context *create_ui(void) {
+    mu_Context *ctx = malloc(sizeof(mu_Context));
+    mu_init(ctx);
+    ctx->text_width = text_width;
+    ctx->text_height = text_height;
+    return ctx;
+}
+
+static void test_frame_stats(void) {
+    mu_Context *ctx = create_ui();
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "First", mu_rect(0, 0, 200, 200))) {
+        mu_button(ctx, "Button");
+        mu_label(ctx, "Label");
+        mu_end_window(ctx);
+    }
+    if (mu_begin_window(ctx, "Second", mu_rect(250, 0, 200, 200))) {
+        mu_open_popup(ctx, "Popup");
+        if (mu_begin_popup(ctx, "Popup")) {
+            mu_label(ctx, "Nested");
+            mu_end_popup(ctx);
+        }
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+
+    const mu_FrameStats *stats = mu_get_frame_stats(ctx);
+    check(stats->frame == ctx->frame);
+    check(stats->root_containers == 3);
+    check(stats->roots[0].container == mu_get_container(ctx, "First"));
+    check(stats->roots[0].parent == -1);
+    check(stats->roots[2].parent == 1);
+    check(stats->total.command_bytes == ctx->command_list.idx);
+    check(stats->total.text_width_calls > 0);
+    check(stats->total.clip_pushes > 0);
+    check(stats->total.pool_lookups > 0);
+
+    /* every command belongs to exactly one root container */
+    int commands = 0, bytes = 0;
+    for (int i = 0; i < stats->root_containers; i++) {
+        commands += stats->roots[i].counters.commands;
+        bytes += stats->roots[i].counters.command_bytes;
+        check(stats->roots[i].counters.commands > 0);
+    }
+    check(commands == stats->total.commands);
+    check(bytes == stats->total.command_bytes);
+
+    /* the next frame starts from zero */
+    mu_begin(ctx);
+    check(mu_get_frame_stats(ctx)->root_containers == 0);
+    check(mu_get_frame_stats(ctx)->total.commands == 0);
+    mu_end(ctx);
+    free(ctx);
+}
+
+static void test_pool_evictions(void) {
+    mu_Context *ctx = create_ui();
+    for (int frame = 0; frame < 2; frame++) {
+        mu_begin(ctx);
+        for (int i = 0; i < MU_CONTAINERPOOL_SIZE; i++) {
+            char title[32];
+            snprintf(title, sizeof(title), "Window %d", frame * MU_CONTAINERPOOL_SIZE + i);
+            if (mu_begin_window(ctx, title, mu_rect(0, 0, 100, 100))) {
+                mu_end_window(ctx);
+            }
+            if (i + 1 == MU_ROOTLIST_SIZE) {
+                break;
+            }
+        }
+        mu_end(ctx);
+    }
+    /* the second frame's windows can only be pooled by evicting the first's */
+    check(mu_get_frame_stats(ctx)->total.pool_evictions > 0);
+    free(ctx);
+}
+
+static uint32_t pixel(const soft_renderer_t *sr, int x, int y) {
+    return sr->pixels[y * sr->width + x];
+}
+
+static uint32_t pack(mu_Color color) {
+    uint32_t px;
+    memcpy(&px, &color, sizeof(px));
+    return px;
+}
+
+/* the same widgets from strings, or from interned labels when given */
+static void label_frame(mu_Context *ctx, mu_Label *labels) {
+    mu_Rect rect = mu_rect(10, 10, 180, 180);
+    mu_begin(ctx);
+    if (labels ? mu_begin_window_l(ctx, &labels[0], rect, 0)
+               : mu_begin_window(ctx, "Labels", rect)) {
+        if (labels ? mu_header_l(ctx, &labels[1], MU_OPT_EXPANDED)
+                   : mu_header_ex(ctx, "Header", MU_OPT_EXPANDED)) {
+            labels ? mu_button_l(ctx, &labels[2], 0, MU_OPT_ALIGNCENTER) : mu_button(ctx, "Button");
+            labels ? mu_label_l(ctx, &labels[3], 0) : mu_label(ctx, "Label");
+        }
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+/* initialized at compile time, so the literal hash must be a constant */
+static mu_Label literal_label = MU_LABEL("Label");
+
+static void test_id_hash(void) {
+    const char *text = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEF";
+    check(MU_HASH_LITERAL("") == mu_hash(text, 0));
+    check(MU_HASH_LITERAL("abcdefg") == mu_hash(text, 7));
+    check(MU_HASH_LITERAL("abcdefgh") == mu_hash(text, 8));
+    check(MU_HASH_LITERAL("abcdefghi") == mu_hash(text, 9));
+    check(MU_HASH_LITERAL("abcdefghijklmnopqrstuvwxyz012345") == mu_hash(text, 32));
+    check(MU_HASH_LITERAL("abcdefghijklmnopqrstuvwxyz0123456789") == mu_hash(text, 36));
+
+    /* every length hashes differently, and the same on every platform */
+    int distinct = 1;
+    for (int i = 0; i < 42; i++) {
+        distinct &= mu_hash(text, i) != mu_hash(text, i + 1);
+    }
+    check(distinct);
+    check(mu_hash("!title", 6) == 0xce1a7c6fu);
+
+    mu_Context *ctx = create_ui();
+    mu_Label label = mu_intern_label("Label");
+    check(literal_label.hash == label.hash && literal_label.len == 5);
+    check(mu_get_literal_id(ctx, "Label") == mu_get_id(ctx, "Label", 5));
+    mu_push_id(ctx, "Parent", 6);
+    mu_Id nested = mu_get_literal_id(ctx, "Label");
+    check(nested == mu_get_label_id(ctx, &label));
+    mu_pop_id(ctx);
+    check(nested != mu_get_literal_id(ctx, "Label"));
+    free(ctx);
+}
+
+static void test_labels(void) {
+    mu_Context *strings = create_ui(), *interned = create_ui();
+    mu_Label labels[4] = {
+        mu_intern_label("Labels"),
+        mu_intern_label("Header"),
+        mu_intern_label("Button"),
+        mu_intern_label("Label"),
+    };
+    check(labels[2].len == 6 && labels[2].width == -1);
+    check(mu_get_label_id(strings, &labels[2]) == mu_get_id(strings, "Button", 6));
+
+    /* same ids, so the same containers and identical output */
+    for (int frame = 0; frame < 2; frame++) {
+        label_frame(strings, NULL);
+        label_frame(interned, labels);
+    }
+    check(mu_get_container(interned, "Labels")->rect.w == 180);
+    soft_renderer_t *a = sr_create(200, 200), *b = sr_create(200, 200);
+    sr_clear(a, mu_color(0, 0, 0, 255));
+    sr_clear(b, mu_color(0, 0, 0, 255));
+    sr_render(a, strings);
+    sr_render(b, interned);
+    check(memcmp(a->pixels, b->pixels, 200 * 200 * sizeof(uint32_t)) == 0);
+    sr_destroy(a);
+    sr_destroy(b);
+
+    /* widths are measured once per font */
+    check(labels[2].width == text_width(NULL, "Button", -1));
+    check(mu_get_frame_stats(interned)->total.text_width_calls == 0);
+    check(mu_get_frame_stats(strings)->total.text_width_calls == 4);
+    static int other_font;
+    interned->style->font = &other_font;
+    label_frame(interned, labels);
+    check(mu_get_frame_stats(interned)->total.text_width_calls == 4);
+    check(labels[2].font == &other_font);
+
+    free(strings);
+    free(interned);
+}
+
+static int scroll_frame(mu_Context *ctx, int retained, unsigned version) {
+    int active = MU_RES_ACTIVE;
+    char buf[64];
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "Scroll", mu_rect(0, 0, 200, 160))) {
+        mu_layout_row(ctx, 1, (int[]) {-1}, -1);
+        if (retained) {
+            active = mu_begin_scroll_panel(ctx, "Log", version, 0);
+        }
+        else {
+            mu_begin_panel(ctx, "Log");
+        }
+        if (active) {
+            mu_layout_row(ctx, 2, (int[]) {50, -1}, 0);
+            for (int i = 0; i < 40; i++) {
+                snprintf(buf, sizeof(buf), "Line %d, long enough to be clipped", i);
+                if (i % 2) {
+                    mu_label(ctx, "");
+                }
+                else {
+                    mu_button(ctx, "Go");
+                }
+                mu_label(ctx, buf);
+            }
+        }
+        mu_end_panel(ctx);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+    return active;
+}
+
+static int same_rects(mu_Rect a, mu_Rect b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+static int same_command(const mu_Command *a, const mu_Command *b) {
+    if (a->type != b->type) {
+        return 0;
+    }
+    switch (a->type) {
+    case MU_COMMAND_CLIP:
+        return same_rects(a->clip.rect, b->clip.rect);
+    case MU_COMMAND_RECT:
+        return same_rects(a->rect.rect, b->rect.rect) && pack(a->rect.color) == pack(b->rect.color);
+    case MU_COMMAND_TEXT:
+        return a->text.pos.x == b->text.pos.x && a->text.pos.y == b->text.pos.y &&
+               a->text.len == b->text.len &&
+               !memcmp(mu_text_str(&a->text), mu_text_str(&b->text), a->text.len);
+    case MU_COMMAND_ICON:
+        return a->icon.id == b->icon.id && same_rects(a->icon.rect, b->icon.rect);
+    case MU_COMMAND_FRAME:
+        return same_rects(a->frame.rect, b->frame.rect) &&
+               pack(a->frame.color) == pack(b->frame.color) &&
+               pack(a->frame.border) == pack(b->frame.border) &&
+               a->frame.border_width == b->frame.border_width;
+    case MU_COMMAND_COLUMNS:
+        return same_rects(a->columns.rect, b->columns.rect) &&
+               !memcmp(a->columns.spans, b->columns.spans, a->columns.rect.w * 4);
+    }
+    return 1;
+}
+
+/* both lists draw the same commands */
+static int same_commands(mu_Context *a, mu_Context *b) {
+    mu_Command *ca = NULL, *cb = NULL;
+    int more;
+    while ((more = mu_next_command(a, &ca)) == mu_next_command(b, &cb) && more) {
+        if (!same_command(ca, cb)) {
+            return 0;
+        }
+    }
+    return !more;
+}
+
+static void test_scroll_panel(void) {
+    mu_Context *rebuilt = create_ui(), *retained = create_ui();
+    mu_input_mousemove(rebuilt, 150, 80);
+    mu_input_mousemove(retained, 150, 80);
+    check(scroll_frame(retained, 1, 1) == MU_RES_ACTIVE);
+    scroll_frame(rebuilt, 0, 1);
+    check(same_commands(rebuilt, retained));
+
+    /* wheel scrolling replays the recorded content, moved and clipped */
+    for (int frame = 0; frame < 6; frame++) {
+        int dy = frame < 4 ? 37 : -50;
+        mu_input_scroll(rebuilt, 0, dy);
+        mu_input_scroll(retained, 0, dy);
+        int active = scroll_frame(retained, 1, 1);
+        scroll_frame(rebuilt, 0, 1);
+        check(frame == 0 ? active == MU_RES_ACTIVE : active == 0);
+        check(same_commands(rebuilt, retained));
+    }
+    mu_Container *a = mu_get_container(rebuilt, "Scroll");
+    mu_Container *b = mu_get_container(retained, "Scroll");
+    check(a->scroll.y == 0 && b->scroll.y == 0); /* the window doesn't scroll */
+    const mu_FrameStats *stats = mu_get_frame_stats(retained);
+    check(stats->total.commands == mu_get_frame_stats(rebuilt)->total.commands);
+    check(stats->total.text_width_calls < mu_get_frame_stats(rebuilt)->total.text_width_calls);
+
+    /* content under the mouse, a new version, or a change of focus is drawn anew */
+    mu_input_mousemove(retained, 30, 100);
+    check(scroll_frame(retained, 1, 1) == MU_RES_ACTIVE);
+    mu_input_mousemove(retained, 150, 80);
+    check(scroll_frame(retained, 1, 1) == MU_RES_ACTIVE); /* to unhover it */
+    check(scroll_frame(retained, 1, 1) == 0);
+    check(scroll_frame(retained, 1, 2) == MU_RES_ACTIVE);
+    check(scroll_frame(retained, 1, 2) == 0);
+    mu_set_focus(retained, mu_get_literal_id(retained, "Elsewhere"));
+    check(scroll_frame(retained, 1, 2) == MU_RES_ACTIVE);
+
+    free(rebuilt);
+    free(retained);
+}
+
+/* a plain panel scrolling inside a scroll panel, which scrolls too */
+static int nested_frame(mu_Context *ctx, int retained, mu_Container **inner) {
+    int active = MU_RES_ACTIVE;
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "Nested", mu_rect(0, 0, 200, 240))) {
+        mu_layout_row(ctx, 1, (int[]) {-1}, -1);
+        if (retained) {
+            active = mu_begin_scroll_panel(ctx, "Outer", 1, 0);
+        }
+        else {
+            mu_begin_panel(ctx, "Outer");
+        }
+        if (active) {
+            for (int i = 0; i < 6; i++) {
+                mu_label(ctx, "Outer line");
+            }
+            mu_layout_row(ctx, 1, (int[]) {-1}, 80);
+            mu_begin_panel(ctx, "Inner");
+            *inner = mu_get_current_container(ctx);
+            mu_layout_row(ctx, 1, (int[]) {-1}, 0);
+            for (int i = 0; i < 20; i++) {
+                mu_label(ctx, "Inner line");
+            }
+            mu_end_panel(ctx);
+        }
+        mu_end_panel(ctx);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+    return active;
+}
+
+static void test_nested_scroll(void) {
+    mu_Context *rebuilt = create_ui(), *retained = create_ui();
+    mu_Container *a = NULL, *b = NULL;
+    mu_input_mousemove(rebuilt, 40, 40);
+    mu_input_mousemove(retained, 40, 40);
+    for (int frame = 0; frame < 3; frame++) {
+        check(nested_frame(retained, 1, &b) == (frame > 1 ? 0 : MU_RES_ACTIVE));
+        nested_frame(rebuilt, 0, &a);
+        check(same_commands(rebuilt, retained));
+    }
+
+    /* the wheel over the inner panel scrolls it, not the replayed one */
+    mu_Vec2 center = mu_vec2(a->body.x + a->body.w / 2, a->body.y + a->body.h / 2);
+    mu_input_mousemove(rebuilt, center.x, center.y);
+    mu_input_mousemove(retained, center.x, center.y);
+    for (int frame = 0; frame < 3; frame++) {
+        mu_input_scroll(rebuilt, 0, 20);
+        mu_input_scroll(retained, 0, 20);
+        nested_frame(retained, 1, &b);
+        nested_frame(rebuilt, 0, &a);
+        check(same_commands(rebuilt, retained));
+    }
+    check(a->scroll.y > 0 && b->scroll.y == a->scroll.y);
+
+    /* and its new scroll is kept once the content is replayed again */
+    mu_input_mousemove(rebuilt, 40, 40);
+    mu_input_mousemove(retained, 40, 40);
+    int replayed = 0;
+    for (int frame = 0; frame < 4; frame++) {
+        replayed += nested_frame(retained, 1, &b) == 0;
+        nested_frame(rebuilt, 0, &a);
+        check(same_commands(rebuilt, retained));
+    }
+    check(replayed > 0);
+
+    free(rebuilt);
+    free(retained);
+}
+
+static char cached_text[16];
+
+static int cached_frame(mu_Context *ctx, int cached, unsigned version, int *clicks) {
+    int active = MU_RES_ACTIVE;
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "Cached", mu_rect(0, 0, 200, 200))) {
+        mu_label(ctx, "Before");
+        if (cached) {
+            active = mu_begin_cached(ctx, mu_get_literal_id(ctx, "Tools"), version);
+        }
+        if (active) {
+            mu_layout_row(ctx, 2, (int[]) {80, -1}, 0);
+            *clicks += mu_button(ctx, "One") ? 1 : 0;
+            mu_label(ctx, "first");
+            *clicks += mu_button(ctx, "Two") ? 1 : 0;
+            mu_label(ctx, "second");
+            mu_textbox(ctx, cached_text, sizeof(cached_text));
+            mu_label(ctx, "third");
+        }
+        if (cached) {
+            mu_end_cached(ctx);
+        }
+        mu_label(ctx, "After");
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+    return active;
+}
+
+static void test_cached_region(void) {
+    mu_Context *rebuilt = create_ui(), *cached = create_ui();
+    int clicks = 0;
+    mu_input_mousemove(rebuilt, 150, 180);
+    mu_input_mousemove(cached, 150, 180);
+    /* copied while nothing changes, with the layout it left behind; the
+    ** window's layout only settles after its first frame */
+    for (int frame = 0; frame < 4; frame++) {
+        check(cached_frame(cached, 1, 1, &clicks) == (frame > 1 ? 0 : MU_RES_ACTIVE));
+        cached_frame(rebuilt, 0, 1, &clicks);
+        check(same_commands(rebuilt, cached));
+    }
+    int calls = mu_get_frame_stats(cached)->total.text_width_calls;
+    check(calls < mu_get_frame_stats(rebuilt)->total.text_width_calls);
+    check(cached_frame(cached, 1, 2, &clicks) == MU_RES_ACTIVE);
+    check(cached_frame(cached, 1, 2, &clicks) == 0);
+
+    /* hovering and clicking a control builds it again */
+    mu_input_mousemove(rebuilt, 40, 60);
+    mu_input_mousemove(cached, 40, 60);
+    for (int frame = 0; frame < 2; frame++) {
+        check(cached_frame(cached, 1, 2, &clicks) == MU_RES_ACTIVE);
+        cached_frame(rebuilt, 0, 2, &clicks);
+        check(same_commands(rebuilt, cached));
+    }
+    mu_input_mousedown(cached, 40, 60, MU_MOUSE_LEFT);
+    cached_frame(cached, 1, 2, &clicks);
+    mu_input_mouseup(cached, 40, 60, MU_MOUSE_LEFT);
+    cached_frame(cached, 1, 2, &clicks);
+    check(clicks == 1);
+    mu_input_mousemove(cached, 150, 180);
+    check(cached_frame(cached, 1, 2, &clicks) == MU_RES_ACTIVE); /* to unhover it */
+    check(cached_frame(cached, 1, 2, &clicks) == 0);
+
+    /* focus given to a control in it outlasts the frame */
+    mu_input_mousemove(cached, 40, 110);
+    cached_frame(cached, 1, 2, &clicks);
+    mu_input_mousedown(cached, 40, 110, MU_MOUSE_LEFT);
+    cached_frame(cached, 1, 2, &clicks);
+    mu_Id textbox = cached->focus;
+    check(textbox != 0);
+    mu_input_mouseup(cached, 40, 110, MU_MOUSE_LEFT);
+    mu_input_mousemove(cached, 150, 180);
+    cached_frame(cached, 1, 2, &clicks);
+    mu_set_focus(cached, 0);
+    cached_frame(cached, 1, 2, &clicks);
+    check(cached_frame(cached, 1, 2, &clicks) == 0);
+    mu_set_focus(cached, textbox);
+    check(cached_frame(cached, 1, 2, &clicks) == MU_RES_ACTIVE);
+    cached_frame(cached, 1, 2, &clicks);
+    check(cached->focus == textbox);
+
+    free(rebuilt);
+    free(cached);
+}
+
+typedef struct
+{
+    int tall; /* every tenth row is taller */
+    int calls, first;
+    mu_Container *panel;
+} table_rows_t;
+
+static void table_row(mu_Context *ctx, int row, void *udata) {
+    table_rows_t *rows = udata;
+    char buf[16];
+    if (rows->calls++ == 0) {
+        rows->first = row;
+        rows->panel = mu_get_current_container(ctx);
+    }
+    if (rows->tall && row % 10 == 0) {
+        mu_layout_height(ctx, 40);
+    }
+    snprintf(buf, sizeof(buf), "%d", row);
+    mu_label(ctx, buf);
+    mu_label(ctx, "cell");
+}
+
+static void table_frame(mu_Context *ctx, mu_Table *table) {
+    ((table_rows_t *) table->udata)->calls = 0;
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "Table", mu_rect(0, 0, 200, 300))) {
+        mu_layout_row(ctx, 1, (int[]) {-1}, -1);
+        mu_begin_table(ctx, "Rows", table, 0);
+        mu_end_table(ctx);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+static void test_table(void) {
+    mu_Context *ctx = create_ui();
+    const char *titles[] = {"Id", "Value"};
+    table_rows_t rows = {0};
+    mu_Table table = {2, (int[]) {60, -1}, titles, 1000000, 20, NULL, 0, table_row, &rows};
+
+    /* only rows in view are laid out, the content covers all of them */
+    table_frame(ctx, &table);
+    table_frame(ctx, &table);
+    check(rows.first == 0 && rows.calls > 5 && rows.calls < 15);
+    check(rows.panel->content_size.y == 24 + 1000000 * 24 - 4);
+    rows.panel->scroll.y = 500000 * 24 + 10;
+    table_frame(ctx, &table);
+    check(rows.first == 500000 && rows.calls < 15);
+    check(mu_get_frame_stats(ctx)->total.commands < 100);
+
+    /* measured rows, found by their cached heights */
+    rows.tall = 1;
+    table.rows = 1000;
+    table.row_height = 0;
+    table.heights = malloc(1000 * sizeof(int));
+    rows.panel->scroll.y = 0;
+    table_frame(ctx, &table);
+    check(rows.first == 0);
+    while (rows.panel->scroll.y < rows.panel->content_size.y - rows.panel->body.h) {
+        rows.panel->scroll.y += rows.panel->body.h;
+        table_frame(ctx, &table);
+    }
+    check(rows.panel->content_size.y == 24 + 1000 * 24 + 100 * 20 - 4);
+    rows.panel->scroll.y = 505 * 24 + 51 * 20;
+    table_frame(ctx, &table);
+    check(rows.first == 505);
+    rows.panel->scroll.y = 505 * 24 + 51 * 20 - 1;
+    table_frame(ctx, &table);
+    check(rows.first == 504);
+
+    free(table.heights);
+    free(ctx);
+}
+
+/* plots `count` samples, from a series when given, into a 200 x 50 rect */
+static const mu_ColumnsCommand *
+plot_frame(mu_Context *ctx, const mu_Plot *series, const float *samples, int count) {
+    mu_Command *cmd = NULL;
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "Plot", mu_rect(0, 0, 300, 300), MU_OPT_NOFRAME)) {
+        mu_layout_row(ctx, 1, (int[]) {202}, 52);
+        if (series) {
+            mu_plot_series(ctx, series, count, -1, 1);
+        }
+        else {
+            mu_plot(ctx, samples, count, -1, 1);
+        }
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+    while (mu_next_command(ctx, &cmd)) {
+        if (cmd->type == MU_COMMAND_COLUMNS) {
+            return &cmd->columns;
+        }
+    }
+    return NULL;
+}
+
+static void test_plot(void) {
+    mu_Context *ctx = create_ui(), *ref = create_ui();
+    float *samples = calloc(100000, sizeof(float));
+    const mu_ColumnsCommand *cols;
+    int spike = 0, rest = 0;
+
+    /* a spike in 100000 samples still reaches the top, in one column */
+    samples[54321] = 1;
+    cols = plot_frame(ctx, NULL, samples, 100000);
+    check(cols && cols->rect.w == 200 && cols->rect.h == 50);
+    check(cols->base.size < 200 * 4 + 64);
+    for (int i = 0; cols && i < 200; i++) {
+        spike += cols->spans[i * 2] == 0 && cols->spans[i * 2 + 1] == 26;
+        rest += cols->spans[i * 2] == 25 && cols->spans[i * 2 + 1] == 26;
+    }
+    check(spike == 1 && rest == 199);
+
+    /* few samples are joined across the columns between them */
+    samples[0] = -1;
+    samples[1] = 1;
+    cols = plot_frame(ctx, NULL, samples, 2);
+    check(cols && cols->spans[0] == 0 && cols->spans[1] == 50);
+    check(cols && cols->spans[199 * 2] == 0 && cols->spans[199 * 2 + 1] == 1);
+
+    /* a series appended in uneven chunks, past its capacity, plots the same
+    ** from its pyramid as its samples do from a plain scan */
+    mu_Plot plot;
+    float buf[4096], pyramid[2048];
+    mu_plot_init(&plot, buf, pyramid, 4096);
+    for (int i = 0, n = 0; i < 100000; i += n, n = n % 997 + 13) {
+        for (int j = 0; j < n; j++) {
+            samples[j] = ((i + j) * 7919 % 2001 - 1000) / 1000.f * ((i + j) % 1000 < 500);
+        }
+        mu_plot_append(&plot, samples, n);
+    }
+    check(plot.count > 2048 && plot.count <= 4096);
+    cols = plot_frame(ctx, &plot, NULL, 3000);
+    plot_frame(ref, NULL, plot.samples + plot.count - 3000, 3000);
+    check(cols && same_commands(ctx, ref));
+    plot_frame(ctx, &plot, NULL, 100000);
+    plot_frame(ref, NULL, plot.samples, plot.count);
+    check(same_commands(ctx, ref));
+
+    /* the soft renderer draws each column's span */
+    soft_renderer_t *sr = sr_create(8, 8);
+    unsigned short spans[] = {0, 8, 2, 3, 2, 3, 4, 4};
+    sr_clear(sr, mu_color(0, 0, 0, 255));
+    sr_draw_columns(sr, mu_rect(2, 0, 4, 8), spans, mu_color(255, 255, 255, 255));
+    check(pixel(sr, 2, 0) == pack(mu_color(255, 255, 255, 255)));
+    check(pixel(sr, 2, 7) == pack(mu_color(255, 255, 255, 255)));
+    check(pixel(sr, 4, 2) == pack(mu_color(255, 255, 255, 255)));
+    check(pixel(sr, 4, 3) == pack(mu_color(0, 0, 0, 255)));
+    check(pixel(sr, 5, 4) == pack(mu_color(0, 0, 0, 255)));
+    sr_destroy(sr);
+
+    /* which is one rect per run of equal spans, skipping empty ones */
+    mu_Rect run;
+    int index = 0;
+    check(mu_next_column_run(mu_rect(2, 0, 4, 8), spans, &index, &run));
+    check(same_rects(run, mu_rect(2, 0, 1, 8)));
+    check(mu_next_column_run(mu_rect(2, 0, 4, 8), spans, &index, &run));
+    check(same_rects(run, mu_rect(3, 2, 2, 1)));
+    check(!mu_next_column_run(mu_rect(2, 0, 4, 8), spans, &index, &run) && index == 4);
+
+    free(samples);
+    free(ref);
+    free(ctx);
+}
+
+static void test_soft_renderer_draw(void) {
+    soft_renderer_t *sr = sr_create(64, 32);
+    sr_set_isa(sr, SR_ISA_SCALAR);
+    sr_clear(sr, mu_color(0, 0, 0, 255));
+
+    /* opaque fill, then GL-style SRC_ALPHA / ONE_MINUS_SRC_ALPHA blend */
+    sr_draw_rect(sr, mu_rect(0, 0, 10, 10), mu_color(200, 100, 50, 255));
+    check(pixel(sr, 9, 9) == pack(mu_color(200, 100, 50, 255)));
+    check(pixel(sr, 10, 9) == pack(mu_color(0, 0, 0, 255)));
+    sr_draw_rect(sr, mu_rect(0, 0, 10, 10), mu_color(0, 0, 255, 128));
+    check(pixel(sr, 0, 0) == pack(mu_color(100, 50, 153, 191)));
+
+    /* clipping, including rects reaching outside the framebuffer */
+    sr_set_clip_rect(sr, mu_rect(20, 0, 4, 4));
+    sr_draw_rect(sr, mu_rect(-100, -100, 1000, 1000), mu_color(255, 255, 255, 255));
+    check(pixel(sr, 20, 0) == pack(mu_color(255, 255, 255, 255)));
+    check(pixel(sr, 23, 3) == pack(mu_color(255, 255, 255, 255)));
+    check(pixel(sr, 24, 3) == pack(mu_color(0, 0, 0, 255)));
+    check(pixel(sr, 20, 4) == pack(mu_color(0, 0, 0, 255)));
+
+    /* glyphs only touch pixels inside their atlas cell */
+    sr_set_clip_rect(sr, mu_rect(0, 0, 64, 32));
+    sr_clear(sr, mu_color(0, 0, 0, 255));
+    sr_draw_text(sr, "A", -1, mu_vec2(30, 10), mu_color(255, 255, 255, 255));
+    int lit = 0, outside = 0;
+    for (int y = 0; y < 32; y++) {
+        for (int x = 0; x < 64; x++) {
+            if (pixel(sr, x, y) != pack(mu_color(0, 0, 0, 255))) {
+                lit++;
+                outside += x < 30 || x >= 30 + sr_get_text_width("A", 1) || y < 10 ||
+                           y >= 10 + sr_get_text_height();
+            }
+        }
+    }
+    check(lit > 0);
+    check(outside == 0);
+    sr_destroy(sr);
+}
+
+/* overlapping windows with clipped text, crossing tile boundaries */
+static void soft_frame(mu_Context *ctx) {
+    mu_begin(ctx);
+    for (int i = 0; i < 3; i++) {
+        char title[32];
+        snprintf(title, sizeof(title), "Window %d", i);
+        if (mu_begin_window(ctx, title, mu_rect(i * 37, i * 29, 211, 157))) {
+            mu_label(ctx, "The quick brown fox jumps over the lazy dog");
+            mu_button(ctx, "Button");
+            int checked = 1;
+            mu_checkbox(ctx, "Checkbox", &checked);
+            mu_end_window(ctx);
+        }
+    }
+    mu_end(ctx);
+}
+
+static mu_Context *create_soft_frame(int frame_commands) {
+    mu_Context *ctx = create_ui();
+    ctx->frame_commands = frame_commands;
+    soft_frame(ctx);
+    return ctx;
+}
+
+static void test_soft_renderer_isa(void) {
+    mu_Context *ctx = create_soft_frame(0);
+
+    /* every kernel set must match the scalar reference byte for byte */
+    soft_renderer_t *ref = sr_create(301, 227);
+    sr_set_isa(ref, SR_ISA_SCALAR);
+    sr_clear(ref, mu_color(10, 20, 30, 255));
+    sr_render(ref, ctx);
+    for (sr_isa_t isa = SR_ISA_SSE2; isa <= SR_ISA_AVX2; isa++) {
+        soft_renderer_t *sr = sr_create(301, 227);
+        if (sr_set_isa(sr, isa) == isa) {
+            sr_clear(sr, mu_color(10, 20, 30, 255));
+            sr_render(sr, ctx);
+            check(memcmp(sr->pixels, ref->pixels, 301 * 227 * sizeof(uint32_t)) == 0);
+        }
+        sr_destroy(sr);
+    }
+    sr_destroy(ref);
+    free(ctx);
+}
+
+static void test_soft_renderer_tiles(void) {
+    mu_Context *ctx = create_soft_frame(1);
+    soft_renderer_t *ref = sr_create(301, 227);
+    sr_clear(ref, mu_color(10, 20, 30, 255));
+    sr_render(ref, ctx);
+
+    /* tiled output must be identical to the direct path at any thread count */
+    for (int threads = 1; threads <= 4; threads += 3) {
+        soft_renderer_t *sr = sr_create(301, 227);
+        check(sr_set_threads(sr, threads) == 0);
+        for (int frame = 0; frame < 2; frame++) {
+            sr_clear(sr, mu_color(10, 20, 30, 255));
+            sr_render(sr, ctx);
+            check(memcmp(sr->pixels, ref->pixels, 301 * 227 * sizeof(uint32_t)) == 0);
+        }
+        check(sr->clip.x == ref->clip.x && sr->clip.w == ref->clip.w);
+        sr_destroy(sr);
+    }
+    sr_destroy(ref);
+    free(ctx);
+}
+
+static void test_frame_commands(void) {
+    mu_Context *rects = create_soft_frame(0), *frames = create_soft_frame(1);
+    soft_renderer_t *a = sr_create(301, 227), *b = sr_create(301, 227);
+    int count = 0;
+
+    /* one command per frame, drawn just as its five rects */
+    check(mu_get_frame_stats(frames)->total.commands < mu_get_frame_stats(rects)->total.commands);
+    for (mu_Command *cmd = NULL; mu_next_command(frames, &cmd);) {
+        count += cmd->type == MU_COMMAND_FRAME;
+    }
+    check(count > 0);
+    sr_clear(a, mu_color(10, 20, 30, 255));
+    sr_clear(b, mu_color(10, 20, 30, 255));
+    sr_render(a, rects);
+    sr_render(b, frames);
+    check(memcmp(a->pixels, b->pixels, 301 * 227 * sizeof(uint32_t)) == 0);
+
+    /* clipped frames stay rects, also when replayed at another scroll */
+    mu_Context *rebuilt = create_ui(), *retained = create_ui();
+    rebuilt->frame_commands = retained->frame_commands = 1;
+    mu_input_mousemove(rebuilt, 150, 80);
+    mu_input_mousemove(retained, 150, 80);
+    for (int frame = 0; frame < 4; frame++) {
+        mu_input_scroll(rebuilt, 0, 23);
+        mu_input_scroll(retained, 0, 23);
+        scroll_frame(retained, 1, 1);
+        scroll_frame(rebuilt, 0, 1);
+        check(same_commands(rebuilt, retained));
+    }
+
+    sr_destroy(a);
+    sr_destroy(b);
+    free(rebuilt);
+    free(retained);
+    free(rects);
+    free(frames);
+}
+
+/* clipped text lines in a row, and rects to merge, drop or cover */
+static void optimize_frame(mu_Context *ctx) {
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "Optimize", mu_rect(10, 10, 120, 200))) {
+        for (int i = 0; i < 4; i++) {
+            mu_label(ctx, "A label much too long for the window");
+        }
+        mu_Rect r = mu_layout_next(ctx);
+        mu_draw_rect(ctx, mu_rect(r.x, r.y, 20, 10), mu_color(200, 0, 0, 255));
+        mu_draw_rect(ctx, mu_rect(r.x + 20, r.y, 20, 10), mu_color(200, 0, 0, 255));
+        mu_draw_rect(ctx, mu_rect(r.x, r.y + 10, 40, 10), mu_color(200, 0, 0, 255));
+        mu_draw_rect(ctx, mu_rect(r.x, r.y, 40, 20), mu_color(0, 0, 0, 0));
+        mu_draw_rect(ctx, mu_rect(r.x + 50, r.y, 10, 10), mu_color(0, 200, 0, 128));
+        mu_draw_rect(ctx, mu_rect(r.x + 45, r.y, 20, 20), mu_color(0, 0, 200, 255));
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+static void test_optimize_commands(void) {
+    mu_Context *plain = create_ui(), *optimized = create_ui();
+    soft_renderer_t *a = sr_create(200, 240), *b = sr_create(200, 240);
+    int clips = 0, rects = 0;
+    optimized->optimize_commands = 1;
+    optimize_frame(plain);
+    optimize_frame(optimized);
+    check(plain->dropped_commands == 0);
+
+    /* no clip resets between the lines; three red rects make one, the
+    ** transparent and the covered green one are gone */
+    for (mu_Command *cmd = NULL; mu_next_command(optimized, &cmd);) {
+        clips += cmd->type == MU_COMMAND_CLIP;
+        rects += cmd->type == MU_COMMAND_RECT && cmd->rect.color.a != 255;
+    }
+    check(clips == 4 + 1);
+    check(rects == 0);
+    check(optimized->dropped_commands == 3 + 4);
+
+    /* and the frame looks the same */
+    sr_clear(a, mu_color(10, 20, 30, 255));
+    sr_clear(b, mu_color(10, 20, 30, 255));
+    sr_render(a, plain);
+    sr_render(b, optimized);
+    check(memcmp(a->pixels, b->pixels, 200 * 240 * sizeof(uint32_t)) == 0);
+    sr_destroy(a);
+    sr_destroy(b);
+
+    /* overlapping windows, with frame commands */
+    mu_Context *ref = create_soft_frame(1);
+    optimized->frame_commands = 1;
+    soft_frame(optimized);
+    a = sr_create(301, 227);
+    b = sr_create(301, 227);
+    sr_clear(a, mu_color(10, 20, 30, 255));
+    sr_clear(b, mu_color(10, 20, 30, 255));
+    sr_render(a, ref);
+    sr_render(b, optimized);
+    check(memcmp(a->pixels, b->pixels, 301 * 227 * sizeof(uint32_t)) == 0);
+
+    sr_destroy(a);
+    sr_destroy(b);
+    free(ref);
+    free(plain);
+    free(optimized);
+}
+
+/* a window partly and one entirely under the front one */
+static void stacked_frame(mu_Context *ctx) {
+    const char *titles[] = {"Side", "Back", "Front"};
+    mu_Rect rects[] = {{150, 50, 150, 100}, {20, 20, 100, 100}, {0, 0, 200, 200}};
+    mu_begin(ctx);
+    for (int i = 0; i < 3; i++) {
+        if (mu_begin_window(ctx, titles[i], rects[i])) {
+            mu_label(ctx, "The quick brown fox jumps over the lazy dog");
+            mu_button(ctx, "Button");
+            mu_end_window(ctx);
+        }
+    }
+    mu_end(ctx);
+}
+
+/* a window hidden under two side by side, neither covering it alone */
+static void tiled_frame(mu_Context *ctx) {
+    const char *titles[] = {"Under", "Left", "Right"};
+    mu_Rect rects[] = {{40, 40, 200, 100}, {0, 0, 140, 200}, {140, 0, 160, 200}};
+    mu_begin(ctx);
+    for (int i = 0; i < 3; i++) {
+        if (mu_begin_window(ctx, titles[i], rects[i])) {
+            mu_label(ctx, "The quick brown fox jumps over the lazy dog");
+            mu_button(ctx, "Button");
+            mu_end_window(ctx);
+        }
+    }
+    mu_end(ctx);
+}
+
+static void test_cull_occluded(void) {
+    soft_renderer_t *a = sr_create(320, 240), *b = sr_create(320, 240);
+    for (int frame_commands = 0; frame_commands < 2; frame_commands++) {
+        mu_Context *plain = create_ui(), *culled = create_ui();
+        int roots = 0;
+        plain->frame_commands = culled->frame_commands = frame_commands;
+        culled->cull_occluded = 1;
+        stacked_frame(plain);
+        stacked_frame(culled);
+        check(plain->culled_roots == 0 && plain->dropped_commands == 0);
+        check(culled->culled_roots == 1);
+        check(culled->dropped_commands > 0);
+        for (int i = 0; i < culled->root_list.idx; i++) {
+            roots += culled->root_list.items[i] == mu_get_container(culled, "Back");
+        }
+        check(roots == 0);
+
+        sr_clear(a, mu_color(10, 20, 30, 255));
+        sr_clear(b, mu_color(10, 20, 30, 255));
+        sr_render(a, plain);
+        sr_render(b, culled);
+        check(memcmp(a->pixels, b->pixels, 320 * 240 * sizeof(uint32_t)) == 0);
+
+        /* nothing shows through an opaque window, but through a translucent one */
+        culled->style->colors[MU_COLOR_WINDOWBG].a = 200;
+        stacked_frame(culled);
+        check(culled->culled_roots == 0 && culled->dropped_commands == 0);
+
+        /* two covers hide what neither hides alone */
+        culled->style->colors[MU_COLOR_WINDOWBG].a = 255;
+        tiled_frame(plain);
+        tiled_frame(culled);
+        check(culled->culled_roots == 1);
+        for (int i = 0; i < culled->root_list.idx; i++) {
+            check(culled->root_list.items[i] != mu_get_container(culled, "Under"));
+        }
+        sr_clear(a, mu_color(10, 20, 30, 255));
+        sr_clear(b, mu_color(10, 20, 30, 255));
+        sr_render(a, plain);
+        sr_render(b, culled);
+        check(memcmp(a->pixels, b->pixels, 320 * 240 * sizeof(uint32_t)) == 0);
+        free(plain);
+        free(culled);
+    }
+
+    /* windows overlapping each other's title bars and text */
+    mu_Context *ref = create_soft_frame(1), *culled = create_ui();
+    culled->frame_commands = culled->cull_occluded = culled->optimize_commands = 1;
+    soft_frame(culled);
+    sr_clear(a, mu_color(10, 20, 30, 255));
+    sr_clear(b, mu_color(10, 20, 30, 255));
+    sr_render(a, ref);
+    sr_render(b, culled);
+    check(memcmp(a->pixels, b->pixels, 320 * 240 * sizeof(uint32_t)) == 0);
+
+    sr_destroy(a);
+    sr_destroy(b);
+    free(ref);
+    free(culled);
+}
+
+static void flush_nothing(batch_t *batch) {
+    batch->quads = 0;
+}
+
+static void flush_full(batch_t *batch) {
+    (void) batch;
+}
+
+static void test_batch_clip(void) {
+    batch_vertex_t vertices[16 * 4];
+    batch_t batch;
+    batch_init(&batch, vertices, 16, flush_nothing);
+
+    /* unclipped glyph as the reference for the clipped one */
+    batch_draw_text(&batch, "W", -1, mu_vec2(100, 50), mu_color(255, 255, 255, 255));
+    check(batch.quads == 1);
+    batch_vertex_t full[4];
+    memcpy(full, vertices, sizeof(full));
+    int w = batch_text_width("W", 1);
+
+    /* clipping on the left and bottom trims positions and UVs together */
+    batch.quads = 0;
+    batch_set_clip(&batch, mu_rect(102, 0, 1000, 55));
+    batch_draw_text(&batch, "W", -1, mu_vec2(100, 50), mu_color(255, 255, 255, 255));
+    check(batch.quads == 1);
+    check(vertices[0].x == 102 && vertices[3].x == full[3].x);
+    check(vertices[0].y == 50 && vertices[3].y == 55);
+    check(vertices[0].u == full[0].u + (full[3].u - full[0].u) * 2 / w);
+    check(vertices[3].u == full[3].u);
+    check(vertices[0].v == full[0].v);
+    check(vertices[3].v < full[3].v && vertices[3].v > full[0].v);
+
+    /* quads outside the clip rect are dropped, not drawn */
+    batch.quads = 0;
+    batch_set_clip(&batch, mu_rect(0, 0, 10, 10));
+    batch_draw_rect(&batch, mu_rect(20, 20, 5, 5), mu_color(0, 0, 0, 255));
+    batch_draw_text(&batch, "Hidden", -1, mu_vec2(20, 20), mu_color(0, 0, 0, 255));
+    check(batch.quads == 0);
+    batch_draw_rect(&batch, mu_rect(5, 5, 50, 50), mu_color(0, 0, 0, 255));
+    check(batch.quads == 1);
+    check(vertices[3].x == 10 && vertices[3].y == 10);
+
+    /* a flush that makes no room drops the quads and counts them */
+    batch_init(&batch, vertices, 2, flush_full);
+    batch_draw_rect(&batch, mu_rect(0, 0, 5, 5), mu_color(0, 0, 0, 255));
+    batch_draw_text(&batch, "Dropped", -1, mu_vec2(0, 0), mu_color(0, 0, 0, 255));
+    check(batch.quads == 2 && batch.overflow == 6);
+    check(vertices[0].x == 0 && vertices[3].x == 5);
+}
+
+static void cache_frame(mu_Context *ctx, const char *label) {
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "First", mu_rect(0, 0, 200, 200))) {
+        mu_label(ctx, label);
+        mu_button(ctx, "Button");
+        mu_end_window(ctx);
+    }
+    if (mu_begin_window(ctx, "Second", mu_rect(150, 50, 200, 200))) {
+        mu_open_popup(ctx, "Popup");
+        if (mu_begin_popup(ctx, "Popup")) {
+            mu_label(ctx, "Nested");
+            mu_end_popup(ctx);
+        }
+        mu_text(ctx, "The quick brown fox jumps over the lazy dog");
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+/* reference output: every command drawn in order with no cache or workers */
+static void draw_sequential(batch_t *ref, mu_Context *ctx) {
+    batch_init(ref, ref->vertices, ref->capacity, flush_nothing);
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        switch (cmd->type) {
+        case MU_COMMAND_TEXT:
+            batch_draw_text(
+                ref, mu_text_str(&cmd->text), cmd->text.len, cmd->text.pos, cmd->text.color
+            );
+            break;
+        case MU_COMMAND_RECT:
+            batch_draw_rect(ref, cmd->rect.rect, cmd->rect.color);
+            break;
+        case MU_COMMAND_ICON:
+            batch_draw_icon(ref, cmd->icon.id, cmd->icon.rect, cmd->icon.color);
+            break;
+        case MU_COMMAND_COLUMNS:
+            batch_draw_columns(ref, cmd->columns.rect, cmd->columns.spans, cmd->columns.color);
+            break;
+        case MU_COMMAND_FRAME:
+            batch_draw_frame(
+                ref, cmd->frame.rect, cmd->frame.color, cmd->frame.border, cmd->frame.border_width
+            );
+            break;
+        case MU_COMMAND_CLIP:
+            batch_set_clip(ref, cmd->clip.rect);
+            break;
+        }
+    }
+}
+
+static int same_quads(const batch_t *a, const batch_t *b) {
+    return a->quads == b->quads &&
+           memcmp(a->vertices, b->vertices, a->quads * 4 * sizeof(batch_vertex_t)) == 0;
+}
+
+/* renders `ctx` uncached into `ref` and cached into `batch`; both must match */
+static int cached_matches(batch_t *batch, batch_t *ref, batch_cache_t *cache, mu_Context *ctx) {
+    draw_sequential(ref, ctx);
+    batch_init(batch, batch->vertices, batch->capacity, flush_nothing);
+    int regenerated = batch_render(batch, cache, ctx);
+    check(batch->quads > 0 && same_quads(batch, ref));
+    return regenerated;
+}
+
+static void test_batch_cache(void) {
+    mu_Context *ctx = create_ui();
+    batch_t batch, ref;
+    batch_init(&batch, malloc(1024 * 4 * sizeof(batch_vertex_t)), 1024, flush_nothing);
+    batch_init(&ref, malloc(1024 * 4 * sizeof(batch_vertex_t)), 1024, flush_nothing);
+    batch_cache_t *cache = batch_cache_create();
+
+    /* the first frame fills every range, including the nested popup */
+    cache_frame(ctx, "Label");
+    check(cached_matches(&batch, &ref, cache, ctx) == 3);
+
+    /* unchanged windows are copied, a changed one is regenerated alone */
+    cache_frame(ctx, "Label");
+    check(cached_matches(&batch, &ref, cache, ctx) == 0);
+
+    /* padding inside text commands holds whatever was in the buffer before */
+    cache_frame(ctx, "Label");
+    for (mu_Command *cmd = NULL; mu_next_command(ctx, &cmd);) {
+        size_t end = offsetof(mu_TextCommand, color) + sizeof(mu_Color);
+        if (cmd->type == MU_COMMAND_TEXT) {
+            memset((char *) cmd + end, 0xa5, offsetof(mu_TextCommand, ref) - end);
+        }
+    }
+    check(cached_matches(&batch, &ref, cache, ctx) == 0);
+    cache_frame(ctx, "Changed");
+    check(cached_matches(&batch, &ref, cache, ctx) == 1);
+
+    batch_cache_destroy(cache);
+    free(batch.vertices);
+    free(ref.vertices);
+    free(ctx);
+}
+
+static void text_frame(mu_Context *ctx, const char *text, int opt) {
+    mu_begin(ctx);
+    if (mu_begin_window(ctx, "Log", mu_rect(0, 0, 200, 200))) {
+        mu_text_ex(ctx, text, opt);
+        mu_label_ex(ctx, text + 4, opt);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+static void test_text_refs(void) {
+    mu_Context *copied = create_ui(), *referenced = create_ui();
+    char text[] = "First line of the log\nsecond, wrapped into a few rows of text";
+    text_frame(copied, text, 0);
+    text_frame(referenced, text, MU_OPT_NOCOPY);
+    check(referenced->command_list.idx < copied->command_list.idx);
+
+    /* lines are referenced in place, so they aren't null-terminated */
+    mu_Command *cmd = NULL;
+    int lines = 0;
+    while (mu_next_command(referenced, &cmd)) {
+        if (cmd->type == MU_COMMAND_TEXT && cmd->text.ref && lines++ == 0) {
+            check(cmd->text.ref == text && text[cmd->text.len] == ' ');
+        }
+    }
+    check(lines > 3);
+
+    /* both draw the same pixels */
+    soft_renderer_t *a = sr_create(200, 200), *b = sr_create(200, 200);
+    sr_clear(a, mu_color(0, 0, 0, 255));
+    sr_clear(b, mu_color(0, 0, 0, 255));
+    sr_render(a, copied);
+    sr_render(b, referenced);
+    check(memcmp(a->pixels, b->pixels, 200 * 200 * sizeof(uint32_t)) == 0);
+    sr_destroy(a);
+    sr_destroy(b);
+
+    /* the cache hashes the referenced bytes, not the pointer */
+    batch_t batch, ref;
+    batch_init(&batch, malloc(1024 * 4 * sizeof(batch_vertex_t)), 1024, flush_nothing);
+    batch_init(&ref, malloc(1024 * 4 * sizeof(batch_vertex_t)), 1024, flush_nothing);
+    batch_cache_t *cache = batch_cache_create();
+    text_frame(referenced, text, MU_OPT_NOCOPY); /* now with its scrollbar */
+    check(cached_matches(&batch, &ref, cache, referenced) == 1);
+    text_frame(referenced, text, MU_OPT_NOCOPY);
+    check(cached_matches(&batch, &ref, cache, referenced) == 0);
+    text[0] = 'f';
+    text_frame(referenced, text, MU_OPT_NOCOPY);
+    check(cached_matches(&batch, &ref, cache, referenced) == 1);
+
+    batch_cache_destroy(cache);
+    free(batch.vertices);
+    free(ref.vertices);
+    free(copied);
+    free(referenced);
+}
+
+static void test_batch_parallel(void) {
+    /* clipped labels in the narrow window, long unclipped runs in the wide
+    ** ones that get cut into several jobs */
+    mu_Context *ctx = create_ui();
+    mu_begin(ctx);
+    for (int i = 0; i < 3; i++) {
+        char title[32];
+        snprintf(title, sizeof(title), "Window %d", i);
+        if (mu_begin_window(ctx, title, mu_rect(i * 37, i * 29, i ? 400 : 211, 900))) {
+            for (int line = 0; line < 60; line++) {
+                mu_label(ctx, "The quick brown fox jumps over the lazy dog");
+            }
+            mu_end_window(ctx);
+        }
+    }
+    mu_end(ctx);
+
+    int capacity = 16384;
+    batch_t batch, ref;
+    batch_init(&batch, malloc(capacity * 4 * sizeof(batch_vertex_t)), capacity, flush_nothing);
+    batch_init(&ref, malloc(capacity * 4 * sizeof(batch_vertex_t)), capacity, flush_nothing);
+    draw_sequential(&ref, ctx);
+
+    /* parallel output must be identical to the sequential path */
+    batch_workers_t *workers = batch_workers_create(4, 0);
+    check(batch_render_parallel(&batch, workers, ctx) > 3);
+    check(same_quads(&batch, &ref));
+    check(batch.clip.x == ref.clip.x && batch.clip.w == ref.clip.w);
+    batch_workers_destroy(workers);
+
+    /* below the threshold the frame is drawn sequentially */
+    workers = batch_workers_create(4, 1000000);
+    batch_init(&batch, batch.vertices, capacity, flush_nothing);
+    check(batch_render_parallel(&batch, workers, ctx) == 0);
+    check(same_quads(&batch, &ref));
+    batch_workers_destroy(workers);
+
+    free(batch.vertices);
+    free(ref.vertices);
+    free(ctx);
+}
+
+static int coverage(const glyph_atlas_t *ga, mu_Rect r) {
+    int sum = 0;
+    for (int y = r.y; y < r.y + r.h; y++) {
+        for (int x = r.x; x < r.x + r.w; x++) {
+            sum += ga_texture(ga)[y * GA_TEXTURE_WIDTH + x];
+        }
+    }
+    return sum;
+}
+
+static void test_glyph_atlas(void) {
+    /* 2-, 3- and 4-byte sequences, then malformed ones one byte at a time */
+    unsigned cp;
+    check(ga_decode_utf8("\xc3\xa9", 4, &cp) == 2 && cp == 0xe9);
+    check(ga_decode_utf8("\xe2\x80\x94", 4, &cp) == 3 && cp == 0x2014);
+    check(ga_decode_utf8("\xf0\x9f\x98\x80", 4, &cp) == 4 && cp == 0x1f600);
+    check(ga_decode_utf8("\xc3\xa9", 1, &cp) == 1 && cp == 0xfffd);
+    check(ga_decode_utf8("\xc0\xaf", 4, &cp) == 1 && cp == 0xfffd);
+    check(ga_decode_utf8("\xed\xa0\x80", 4, &cp) == 1 && cp == 0xfffd);
+    check(ga_decode_utf8("\xa9x", 4, &cp) == 1 && cp == 0xfffd);
+
+    /* one advance per code point: accented letters like their base letter,
+    ** anything without a glyph like the box */
+    check(ga_text_width("caf\xc3\xa9", -1) == ga_text_width("cafe", -1));
+    check(ga_text_width("\xe2\x98\x83", -1) == ga_text_width("\x7f", -1));
+    check(ga_text_width("caf\xc3\xa9", 4) == ga_text_width("caf\x7f", -1));
+
+    /* accented glyphs are packed beyond the baked pages, with the accent
+    ** adding coverage to the base letter, and uploaded once */
+    glyph_atlas_t *ga = ga_create(3);
+    mu_Rect src, base, dirty;
+    check(ga_lookup(ga, 0xe9, &src) == 2 && src.y >= 2 * GA_PAGE_HEIGHT);
+    ga_lookup(ga, 'e', &base);
+    check(src.w == base.w && src.h == base.h);
+    check(coverage(ga, src) > coverage(ga, base));
+    check(ga_take_dirty(ga, &dirty) && dirty.y <= src.y && dirty.y + dirty.h > src.y);
+    check(!ga_take_dirty(ga, &dirty));
+    mu_Rect again;
+    check(ga_lookup(ga, 0xe9, &again) == 2 && again.x == src.x && again.y == src.y);
+    check(!ga_take_dirty(ga, &dirty));
+
+    /* glyphs that don't fit fall back to the baked font; the page was used
+    ** this frame, so it isn't evicted */
+    unsigned missed = 0;
+    for (unsigned c = 0xc0; c <= 0xff; c++) {
+        if (ga_lookup(ga, c, &src) < 2 && !missed && ga_advance(c) != ga_advance(0x7f)) {
+            missed = c;
+        }
+    }
+    check(missed && ga_epoch(ga) == 0);
+
+    /* next frame the least recently used page makes room */
+    ga_begin_frame(ga);
+    check(ga_lookup(ga, missed, &src) == 2 && ga_epoch(ga) == 1);
+    check(ga_lookup(ga, 0xe9, &src) == 2 && ga_epoch(ga) == 1);
+
+    /* touched pages are kept like looked up ones */
+    ga_begin_frame(ga);
+    ga_touch_pages(ga, 1u << 2);
+    for (unsigned c = 0xc0; c <= 0xff; c++) {
+        ga_lookup(ga, c, &src);
+    }
+    check(ga_epoch(ga) == 1);
+
+    /* the batch draws from the atlas and advances like the metrics */
+    const char *text = "\xc3\xa9t\xc3\xa9";
+    batch_vertex_t vertices[8 * 4];
+    batch_t batch;
+    batch_init(&batch, vertices, 8, flush_nothing);
+    batch.glyphs = ga;
+    batch_draw_text(&batch, text, -1, mu_vec2(0, 0), mu_color(255, 255, 255, 255));
+    check(batch.quads == 3 && batch.pages & 1u << 2);
+    check(vertices[0].v >= 2 * GA_PAGE_HEIGHT / (float) GA_TEXTURE_HEIGHT);
+    check(vertices[11].x == batch_text_width(text, -1));
+
+    /* without an atlas the base letter stands in */
+    batch_init(&batch, vertices, 8, flush_nothing);
+    batch_draw_text(&batch, text, -1, mu_vec2(0, 0), mu_color(255, 255, 255, 255));
+    check(batch.quads == 3 && batch.pages == 0);
+    check(vertices[11].x == batch_text_width("ete", -1));
+
+    /* a sequence cut off by the length is drawn as measured, from its bytes */
+    const char *cut = text;
+    check(ga_next_baked(&cut, 1) == 127 && cut == text + 1);
+    batch_init(&batch, vertices, 8, flush_nothing);
+    batch.glyphs = ga;
+    batch_draw_text(&batch, text, 4, mu_vec2(0, 0), mu_color(255, 255, 255, 255));
+    check(batch.quads == 3 && vertices[11].x == batch_text_width(text, 4));
+
+    /* the software renderer shows the same accents as the batch */
+    soft_renderer_t *plain = sr_create(32, 32), *accented = sr_create(32, 32);
+    sr_clear(plain, mu_color(0, 0, 0, 255));
+    sr_clear(accented, mu_color(0, 0, 0, 255));
+    sr_draw_text(plain, "e", -1, mu_vec2(0, 0), mu_color(255, 255, 255, 255));
+    sr_draw_text(accented, "\xc3\xa9", -1, mu_vec2(0, 0), mu_color(255, 255, 255, 255));
+    check(memcmp(plain->pixels, accented->pixels, 32 * 32 * sizeof(uint32_t)) != 0);
+    sr_destroy(plain);
+    sr_destroy(accented);
+    ga_destroy(ga);
+}
+
+static void test_glyph_runs(void) {
+    /* kernels load whole blocks, but never from the page after a string */
+    char *pages = aligned_alloc(4096, 8192);
+    memset(pages, 'W', 8192);
+    char *tail = pages + 4096 - 37;
+    tail[36] = '\0';
+    check(mprotect(pages + 4096, 4096, PROT_NONE) == 0);
+
+    const char *texts[] = {
+        "",
+        "Hello, world!",
+        "Slider 42: the quick brown fox jumps over the lazy dog, twice over.",
+        "caf\xc3\xa9 na\xc3\xafve r\xc3\xa9sum\xc3\xa9 \xe2\x80\x94 0123456789abcdefghijklmnop",
+        "tab\there\x01\x7f ctrl\nnewline and a rather long line of plain text after it",
+        tail,
+    };
+    int lens[] = {-1, 0, 5, 16, 31, 33};
+
+    ga_set_isa(GA_ISA_SCALAR);
+    int ref_width[6][6], ref_run[6], ref_x[6], ref_offsets[6][80];
+    for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < 6; j++) {
+            ref_width[i][j] = ga_text_width(texts[i], lens[j]);
+        }
+        ref_x[i] = 3;
+        ref_run[i] = ga_ascii_run(texts[i], 80, &ref_x[i], ref_offsets[i]);
+    }
+    check(ref_width[1][0] == batch_text_width("Hello, world!", -1));
+    check(ref_run[3] == 3 && ref_run[5] == 36 && ref_offsets[1][0] == 3);
+
+    for (ga_isa_t isa = GA_ISA_SSSE3; isa <= GA_ISA_AVX2; isa++) {
+        if (ga_set_isa(isa) != isa) {
+            continue;
+        }
+        for (int i = 0; i < 6; i++) {
+            int same = 1;
+            for (int j = 0; j < 6; j++) {
+                same &= ga_text_width(texts[i], lens[j]) == ref_width[i][j];
+            }
+            int x = 3, offsets[80];
+            int run = ga_ascii_run(texts[i], 80, &x, offsets);
+            check(same && run == ref_run[i] && x == ref_x[i]);
+            check(memcmp(offsets, ref_offsets[i], run * sizeof(int)) == 0);
+        }
+    }
+    check(ga_set_isa(GA_ISA_AUTO) != GA_ISA_AUTO);
+    mprotect(pages + 4096, 4096, PROT_READ | PROT_WRITE);
+    free(pages);
+}
+
+static void test_renderer_backends(void) {
+    const char *modes[] = {"window", "gl3", "software", "null"};
+    for (int i = 0; i < 4; i++) {
+        const renderer_backend_t *backend = r_find_backend(modes[i]);
+        check(backend && strcmp(backend->name, modes[i]) == 0);
+        check(backend && backend->windowed == (i < 2));
+    }
+    check(r_find_backend("console") == NULL);
+    check(r_create("console", 64, 64) == NULL);
+
+    /* independent instances side by side, each with its own surface */
+    mu_Context *ctx = create_soft_frame(1);
+    renderer_t *small = r_create("software", 64, 48);
+    renderer_t *large = r_create("software", 301, 227);
+    renderer_t *null = r_create("null", 301, 227);
+    check(small && large && null);
+    check(small->width == 64 && large->width == 301);
+    r_clear(small, mu_color(1, 2, 3, 255));
+    r_clear(large, mu_color(10, 20, 30, 255));
+    for (int i = 0; i < 3; i++) {
+        r_render(small, ctx);
+        r_render(large, ctx);
+        r_render(null, ctx);
+    }
+    check(r_screenshot(null, "/dev/null") != 0);
+    check(r_screenshot(large, "/dev/null") == 0);
+    r_destroy(small);
+    r_destroy(large);
+    r_destroy(null);
+    free(ctx);
+}
 
 int main(int argc, char **argv, char **envp) {
-    printf("Unit tests are not implemented yet.\n");
+    (void) argc;
+    (void) argv;
+    (void) envp;
+
+    test_frame_stats();
+    test_id_hash();
+    test_labels();
+    test_scroll_panel();
+    test_nested_scroll();
+    test_cached_region();
+    test_table();
+    test_plot();
+    test_pool_evictions();
+    test_soft_renderer_draw();
+    test_soft_renderer_isa();
+    test_soft_renderer_tiles();
+    test_frame_commands();
+    test_optimize_commands();
+    test_cull_occluded();
+    test_batch_clip();
+    test_batch_cache();
+    test_text_refs();
+    test_batch_parallel();
+    test_glyph_atlas();
+    test_glyph_runs();
+    test_renderer_backends();
+
+    if (failures) {
+        printf("❌ %d of %d checks failed\n", failures, checks);
+        return 1;
+    }
+    printf("✅ All %d checks passed\n", checks);
     return 0;
 }